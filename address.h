@@ -2,9 +2,14 @@
 #define ADDRESS_H
 
 #include <string>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <unordered_map>
 
 #include "crypto.h"
 #include "base58.h"
+#include "thread_pool.h"
 
 #include "etool/details/result.h"
 
@@ -23,7 +28,11 @@ namespace bchain { namespace address {
         static
         std::string create( const crypto::ec_key &k, std::uint8_t version )
         {
+            /// the bignum drops leading zero bytes; WIF keeps all 32
             auto private_bytes = k.get_private_bytes( );
+            if( !private_bytes.empty( ) && private_bytes.size( ) < 32 ) {
+                private_bytes.insert( 0, 32 - private_bytes.size( ), '\0' );
+            }
             return create( private_bytes, version, k.get_conv_compressed( ) );
         }
 
@@ -58,6 +67,35 @@ namespace bchain { namespace address {
         }
     };
 
+    /// Addresses made in bulk, back to back in one string: address i is
+    /// arena[offsets[i], offsets[i + 1]). An empty entry marks an input
+    /// that could not be encoded.
+    struct address_list {
+
+        std::string              arena;
+        std::vector<std::size_t> offsets;
+
+        std::size_t size( ) const
+        {
+            return offsets.empty( ) ? 0 : offsets.size( ) - 1;
+        }
+
+        const char *data( std::size_t i ) const
+        {
+            return arena.c_str( ) + offsets[i];
+        }
+
+        std::size_t length( std::size_t i ) const
+        {
+            return offsets[i + 1] - offsets[i];
+        }
+
+        std::string at( std::size_t i ) const
+        {
+            return std::string( data( i ), length( i ) );
+        }
+    };
+
     // pay-to-public-key-hash
     struct p2pkh {
 
@@ -154,6 +192,419 @@ namespace bchain { namespace address {
 
             return base58::encode( res );
         }
+
+        /// keys handed to a single worker; every stage runs over a whole
+        /// chunk before the next one starts
+        enum { batch_grain = 256 };
+
+        /// version + hash160 + checksum
+        enum { payload_size = 1 + hash::hash160::digest_length + 4 };
+
+        /// uncompressed secp256k1 point
+        enum { max_key_size = 65 };
+
+        using slice = hash::hash160::slice;
+
+        /// Addresses for 'count' public keys, each 'len' bytes, back to
+        /// back in 'pubs' (ec_key::get_public_bytes_many,
+        /// derive_public_many). A key whose first byte is zero, as those
+        /// calls leave for a failed slot, gives an empty entry.
+        static
+        address_list create_many( const std::uint8_t *pubs, std::size_t len,
+                                  std::size_t count, std::uint8_t prefix,
+                                  thread_pool *pool = nullptr )
+        {
+            return create_many( count, prefix, pool,
+                [pubs, len]( std::size_t b, std::size_t e, slice *dst,
+                             std::uint8_t * ) {
+                    for( std::size_t i=b; i<e; ++i ) {
+                        const std::uint8_t *p = pubs + i * len;
+                        dst[i - b] = slice( p, ( len && p[0] ) ? len : 0 );
+                    }
+                } );
+        }
+
+        /// Same for keys, each in its own conversion form, as
+        /// create( k, prefix ) does. Keys without a public point give an
+        /// empty entry.
+        static
+        address_list create_many( const crypto::ec_key *keys,
+                                  std::size_t count, std::uint8_t prefix,
+                                  thread_pool *pool = nullptr )
+        {
+            return create_many( count, prefix, pool,
+                [keys]( std::size_t b, std::size_t e, slice *dst,
+                        std::uint8_t *points ) {
+                    crypto::bn_ctx ctx;
+                    for( std::size_t i=b; i<e; ++i ) {
+                        const EC_KEY   *k   = keys[i].get( );
+                        const EC_GROUP *g   = k ? EC_KEY_get0_group( k )
+                                                : nullptr;
+                        const EC_POINT *pub = k ? EC_KEY_get0_public_key( k )
+                                                : nullptr;
+                        std::uint8_t   *out = points + ( i - b ) * max_key_size;
+                        std::size_t     len = 0;
+                        if( pub ) {
+                            len = EC_POINT_point2oct( g, pub,
+                                                      EC_KEY_get_conv_form( k ),
+                                                      out, max_key_size,
+                                                      ctx.get( ) );
+                        }
+                        dst[i - b] = slice( out, len );
+                    }
+                } );
+        }
+
+        /// Same for keys given one slice each; lengths may differ. An
+        /// empty slice gives an empty entry.
+        static
+        address_list create_many( const slice *pubs, std::size_t count,
+                                  std::uint8_t prefix,
+                                  thread_pool *pool = nullptr )
+        {
+            return create_many( count, prefix, pool,
+                [pubs]( std::size_t b, std::size_t e, slice *dst,
+                        std::uint8_t * ) {
+                    std::copy( pubs + b, pubs + e, dst );
+                } );
+        }
+
+    private:
+
+        /// 'fill( b, e, dst, scratch )' puts the public keys of [b, e)
+        /// into dst, at most batch_grain at a time; the slices may point
+        /// into 'scratch' (batch_grain * max_key_size bytes). Stages per
+        /// chunk: batched hash160, batched checksum, base58 into fixed
+        /// slots; then the slots are packed into the arena.
+        template <typename FillF>
+        static
+        address_list create_many( std::size_t count, std::uint8_t prefix,
+                                  thread_pool *pool, FillF fill )
+        {
+            const std::size_t slot = base58::encoded_size( payload_size ) + 1;
+
+            std::vector<std::uint8_t> slots(count * slot);
+            std::vector<std::uint8_t> lens(count);
+            thread_pool &tp = pool ? *pool : thread_pool::common( );
+
+            tp.parallel_for( count, batch_grain,
+                [&]( std::size_t b, std::size_t e ) {
+                    for( ; b<e; b+=batch_grain ) {
+                        std::size_t n = ( e - b < batch_grain )
+                                      ? e - b : std::size_t(batch_grain);
+                        slice        pubs[batch_grain];
+                        std::uint8_t scratch[batch_grain * max_key_size];
+                        fill( b, b + n, pubs, scratch );
+                        encode_chunk( pubs, n, prefix,
+                                      &slots[b * slot], slot, &lens[b] );
+                    }
+                } );
+
+            address_list res;
+            res.offsets.resize( count + 1 );
+            res.offsets[0] = 0;
+            for( std::size_t i=0; i<count; ++i ) {
+                res.offsets[i + 1] = res.offsets[i] + lens[i];
+            }
+            res.arena.resize( res.offsets[count] );
+
+            tp.parallel_for( count, batch_grain * 16,
+                [&]( std::size_t b, std::size_t e ) {
+                    for( std::size_t i=b; i<e; ++i ) {
+                        memcpy( &res.arena[res.offsets[i]], &slots[i * slot],
+                                lens[i] );
+                    }
+                } );
+            return res;
+        }
+
+        static
+        void encode_chunk( const slice *pubs, std::size_t count,
+                           std::uint8_t prefix, std::uint8_t *slots,
+                           std::size_t slot, std::uint8_t *lens )
+        {
+            enum { body_size = payload_size - 4 };
+
+            hash::hash160::digest_block keyhash[batch_grain];
+            hash::hash256::digest_block sums[batch_grain];
+            std::uint8_t                body[batch_grain][payload_size];
+            slice                       bodies[batch_grain];
+
+            hash::hash160::get_many( pubs, keyhash, count );
+
+            for( std::size_t i=0; i<count; ++i ) {
+                body[i][0] = prefix;
+                memcpy( &body[i][1], keyhash[i], hash::hash160::digest_length );
+                bodies[i] = slice( body[i], body_size );
+            }
+
+            hash::hash256::get_many( bodies, sums, count );
+
+            for( std::size_t i=0; i<count; ++i ) {
+                if( pubs[i].size( ) == 0 ) {
+                    lens[i] = 0;
+                    continue;
+                }
+                memcpy( &body[i][body_size], sums[i], 4 );
+                lens[i] = static_cast<std::uint8_t>(
+                        base58::encode_fixed<payload_size>( slots + i * slot,
+                                                            body[i] ) );
+            }
+        }
+    };
+
+    /// WIF strings imported in bulk: validated, deduplicated by private
+    /// key and turned into P2PKH addresses. A bad line is reported and
+    /// skipped; it never stops the batch. Lines are numbered from 0, by
+    /// position in the span or in the text.
+    struct wif_batch {
+
+        struct key {
+            std::size_t                   line;
+            std::array<std::uint8_t, 32>  priv;
+            bool                          compressed;
+        };
+
+        struct error {
+            std::size_t  line;
+            const char  *what;
+        };
+
+        /// 'line' holds the same private key as the earlier line 'first'
+        struct duplicate {
+            std::size_t  line;
+            std::size_t  first;
+        };
+
+        /// lines handed to a single worker while decoding
+        enum { decode_grain = 256 };
+
+        std::vector<key>        keys;       /// first occurrences, in order
+        address_list            addresses;  /// one per key
+        std::vector<error>      errors;
+        std::vector<duplicate>  duplicates;
+
+        wif_batch( ) = default;
+        wif_batch( wif_batch && ) = default;
+        wif_batch &operator = ( wif_batch && ) = default;
+
+        ~wif_batch( )
+        {
+            for( auto &k: keys ) {
+                OPENSSL_cleanse( k.priv.data( ), k.priv.size( ) );
+            }
+        }
+
+        /// Only keys of 'version' (wif::VERSION_MAINNET or
+        /// VERSION_TESTNET3) are taken; their addresses get the
+        /// matching P2PKH version.
+        static
+        wif_batch import( const std::string *wifs, std::size_t count,
+                          std::uint8_t version = wif::VERSION_MAINNET,
+                          thread_pool *pool = nullptr )
+        {
+            std::vector<line_ref> lines(count);
+            for( std::size_t i=0; i<count; ++i ) {
+                lines[i] = line_ref { i, wifs[i].c_str( ), wifs[i].size( ) };
+            }
+            return import_lines( lines, version, pool );
+        }
+
+        static
+        wif_batch import( const std::vector<std::string> &wifs,
+                          std::uint8_t version = wif::VERSION_MAINNET,
+                          thread_pool *pool = nullptr )
+        {
+            return import( wifs.data( ), wifs.size( ), version, pool );
+        }
+
+        /// One WIF per line, as in a key dump; surrounding blanks and
+        /// CR are ignored, and so are empty lines.
+        static
+        wif_batch import_text( const std::string &text,
+                               std::uint8_t version = wif::VERSION_MAINNET,
+                               thread_pool *pool = nullptr )
+        {
+            std::vector<line_ref> lines;
+            std::size_t pos = 0;
+            for( std::size_t n=0; pos<text.size( ); ++n ) {
+                std::size_t end = text.find( '\n', pos );
+                if( end == std::string::npos ) {
+                    end = text.size( );
+                }
+                std::size_t b = pos, e = end;
+                while( b < e && is_blank( text[b] ) ) {
+                    ++b;
+                }
+                while( e > b && is_blank( text[e - 1] ) ) {
+                    --e;
+                }
+                if( e > b ) {
+                    lines.push_back( line_ref { n, text.c_str( ) + b, e - b } );
+                }
+                pos = end + 1;
+            }
+            return import_lines( lines, version, pool );
+        }
+
+    private:
+
+        struct line_ref {
+            std::size_t  line;
+            const char  *data;
+            std::size_t  len;
+        };
+
+        struct record {
+            std::uint8_t  priv[32];
+            bool          compressed;
+            const char   *error;
+        };
+
+        struct priv_hash {
+            std::size_t operator ( )( const std::array<std::uint8_t, 32> &k ) const
+            {
+                std::size_t res;
+                memcpy( &res, k.data( ), sizeof(res) );
+                return res;
+            }
+        };
+
+        static
+        bool is_blank( char c )
+        {
+            return c == ' ' || c == '\t' || c == '\r';
+        }
+
+        /// Stages: decode and check every line in parallel, drop
+        /// repeated keys in one serial pass, derive the public keys
+        /// (ec_key::derive_public_many, one context per chunk) and
+        /// encode the addresses (p2pkh::create_many).
+        static
+        wif_batch import_lines( const std::vector<line_ref> &lines,
+                                std::uint8_t version, thread_pool *pool )
+        {
+            wif_batch res;
+            std::uint8_t prefix = version == wif::VERSION_TESTNET3
+                                ? p2pkh::VERSION_TESTNET3
+                                : p2pkh::VERSION_MAINNET;
+            thread_pool &tp = pool ? *pool : thread_pool::common( );
+
+            std::vector<record> recs(lines.size( ));
+            tp.parallel_for( lines.size( ), decode_grain,
+                [&]( std::size_t b, std::size_t e ) {
+                    for( std::size_t i=b; i<e; ++i ) {
+                        decode_line( recs[i], lines[i], version );
+                    }
+                } );
+
+            using priv_type = std::array<std::uint8_t, 32>;
+            std::unordered_map<priv_type, std::size_t, priv_hash> seen;
+            seen.reserve( lines.size( ) );
+
+            for( std::size_t i=0; i<lines.size( ); ++i ) {
+                auto &r = recs[i];
+                if( r.error ) {
+                    res.errors.push_back( error { lines[i].line, r.error } );
+                    continue;
+                }
+                key k;
+                k.line = lines[i].line;
+                k.compressed = r.compressed;
+                memcpy( k.priv.data( ), r.priv, 32 );
+                auto ins = seen.emplace( k.priv, k.line );
+                if( !ins.second ) {
+                    res.duplicates.push_back( duplicate { k.line,
+                                                          ins.first->second } );
+                    OPENSSL_cleanse( k.priv.data( ), k.priv.size( ) );
+                    continue;
+                }
+                res.keys.push_back( k );
+            }
+            OPENSSL_cleanse( recs.data( ), recs.size( ) * sizeof(record) );
+            for( auto &s: seen ) {
+                OPENSSL_cleanse( const_cast<std::uint8_t *>(s.first.data( )),
+                                 s.first.size( ) );
+            }
+
+            const std::size_t count = res.keys.size( );
+            std::vector<std::uint8_t> privs(count * 32);
+            std::vector<std::uint8_t> pubs(count * p2pkh::max_key_size);
+            for( std::size_t i=0; i<count; ++i ) {
+                memcpy( &privs[i * 32], res.keys[i].priv.data( ), 32 );
+            }
+            crypto::ec_key::derive_public_many( privs.data( ), count,
+                                                pubs.data( ), false, pool );
+            OPENSSL_cleanse( privs.data( ), privs.size( ) );
+
+            /// compressed form in place: parity prefix, then the same x
+            std::vector<p2pkh::slice> slices(count);
+            for( std::size_t i=0; i<count; ++i ) {
+                std::uint8_t *p = &pubs[i * p2pkh::max_key_size];
+                std::size_t  len = p2pkh::max_key_size;
+                if( res.keys[i].compressed ) {
+                    p[0] = static_cast<std::uint8_t>(0x02 | ( p[64] & 1 ));
+                    len  = 33;
+                }
+                slices[i] = p2pkh::slice( p, len );
+            }
+            res.addresses = p2pkh::create_many( slices.data( ), count,
+                                                prefix, pool );
+            return res;
+        }
+
+        static
+        void decode_line( record &r, const line_ref &l, std::uint8_t version )
+        {
+            /// version + private bytes (+ compressed flag)
+            enum { UNCOMPRESSED_SIZE = 33, COMPRESSED_SIZE = 34 };
+
+            r.error = nullptr;
+            base58::decoded_buffer buf;
+            if( !base58::decode( buf, l.data, l.len ) ) {
+                r.error = "Invalid WIF. Bad encoding";
+                return;
+            }
+            if( buf.size != UNCOMPRESSED_SIZE + 4 &&
+                buf.size != COMPRESSED_SIZE + 4 )
+            {
+                r.error = "Invalid WIF. Bad length";
+            } else if( buf.data[0] != version ) {
+                r.error = "Invalid WIF. Bad version";
+            } else {
+                std::size_t body = buf.size - 4;
+                hash::hash256::digest_block digit;
+                hash::hash256::get( digit, buf.data, body );
+                if( memcmp( digit, buf.data + body, 4 ) != 0 ) {
+                    r.error = "Invalid WIF. Bad hash";
+                } else if( body == COMPRESSED_SIZE && buf.data[33] != 0x01 ) {
+                    r.error = "Invalid WIF. Bad compression flag";
+                } else if( !valid_private( buf.data + 1 ) ) {
+                    r.error = "Invalid WIF. Bad private value";
+                } else {
+                    memcpy( r.priv, buf.data + 1, 32 );
+                    r.compressed = body == COMPRESSED_SIZE;
+                }
+            }
+            OPENSSL_cleanse( buf.data, sizeof(buf.data) );
+        }
+
+        /// 0 < k < n, big endian
+        static
+        bool valid_private( const std::uint8_t *k )
+        {
+            static const std::uint8_t order[32] = {
+                0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE,
+                0xBA, 0xAE, 0xDC, 0xE6, 0xAF, 0x48, 0xA0, 0x3B,
+                0xBF, 0xD2, 0x5E, 0x8C, 0xD0, 0x36, 0x41, 0x41,
+            };
+            std::uint8_t acc = 0;
+            for( int i=0; i<32; ++i ) {
+                acc |= k[i];
+            }
+            return acc != 0 && memcmp( k, order, 32 ) < 0;
+        }
     };
 
 }}
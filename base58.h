@@ -7,13 +7,56 @@
 
 #include <vector>
 #include <array>
+#include <type_traits>
 
 #include "hash.h"
 
+#if !defined(BITCHAIN_BASE58_NO_SIMD) \
+  && ( defined(__GNUC__) || defined(__clang__) ) \
+  && ( defined(__x86_64__) || defined(__i386__) )
+#   define BITCHAIN_BASE58_X86 1
+#   include <immintrin.h>
+#endif
+
 namespace bchain {
 
     struct base58 {
 
+        /// Payloads up to this many bytes (checksum not counted) are
+        /// converted on the stack without touching the heap.
+        enum { max_payload = 128 };
+
+        /// longest string the stack paths take: payload and checksum,
+        /// at log58(256) < 1.3658 characters per byte
+        enum { max_encoded = ( max_payload + 4 ) * 13658 / 10000 + 1 };
+
+        /// Fixed-capacity result; 'data' is zero-terminated like the
+        /// pointer overloads leave it.
+        template <size_t Cap>
+        struct fixed_buffer {
+
+            enum { capacity = Cap };
+
+            std::uint8_t data[Cap + 1];
+            size_t       size = 0;
+
+            const char *c_str( ) const
+            {
+                return reinterpret_cast<const char *>(data);
+            }
+
+            std::string str( ) const
+            {
+                return std::string( c_str( ), size );
+            }
+        };
+
+        using encoded_buffer = fixed_buffer<max_encoded>;
+
+        /// a run of '1's decodes to one byte per character, so any string
+        /// the stack path takes fits
+        using decoded_buffer = fixed_buffer<max_encoded>;
+
         static
         size_t encoded_size( size_t len )
         {
@@ -24,73 +67,119 @@ namespace bchain {
         static
         int decode( std::uint8_t *dst, const U *sources, size_t lens )
         {
-            //using u8  = std::uint8_t;
             using cu8 = const std::uint8_t;
 
             size_t len = lens * sizeof(U);
             const std::uint8_t * src = reinterpret_cast<cu8 *>(sources);
-            *dst = '\0';
-
-            if( len > 0 ) {
-
-                size_t j = len;
-                size_t c;
-                int    digit58;
-                size_t zc = 0;
-                size_t start;
-                size_t mod;
-
-                std::vector<std::uint8_t> input58(len);
-                std::vector<std::uint8_t> tmp(len);
-
-                for( size_t i=0; i < len; ++i ) {
-
-                    c = src[i];
-
-                    digit58 = -1;
-
-                    if( c < 128) {
-                        digit58 = index(c);
-                    }
-
-                    if( digit58 < 0 ) {
-                        return -1;
-                    }
 
-                    input58[i] = static_cast<std::uint8_t>(digit58 & 0xFF);
+            *dst = '\0';
+            if( len <= max_encoded ) {
+                std::uint8_t  digits[max_encoded];
+                std::uint32_t limbs[decoded_limbs( max_encoded )];
+                if( !map_digits( digits, src, len ) ) {
+                    return -1;
                 }
+                return decode_limbs( dst, digits, len, limbs,
+                                     decoded_limbs( max_encoded ) );
+            }
+            std::vector<std::uint8_t>  digits(len);
+            std::vector<std::uint32_t> limbs(decoded_limbs( len ));
+            if( !map_digits( &digits[0], src, len ) ) {
+                return -1;
+            }
+            return decode_limbs( dst, &digits[0], len,
+                                 &limbs[0], limbs.size( ) );
+        }
 
-                while( zc<len && input58[zc] == 0 ) {
-                    ++zc;
+        /// Validates 'src' against the alphabet and writes digit values
+        /// 0..57 to 'dst', 32 or 16 characters per step where the CPU
+        /// allows. False at the first block holding a character outside
+        /// the alphabet; no arithmetic has been done then.
+        static
+        bool map_digits( std::uint8_t *dst, const std::uint8_t *src,
+                         size_t len )
+        {
+            size_t done = 0;
+#ifdef BITCHAIN_BASE58_X86
+            if( hash::sha256_engine::cpu::features( ).avx2 ) {
+                if( !map_digits_avx2( dst, src, len, done ) ) {
+                    return false;
                 }
-
-                start = zc;
-
-                while( start < len ) {
-
-                    mod = divmod256(&input58[0], start, len);
-
-                    if( input58[start] == 0 ) {
-                        ++start;
-                    }
-                    tmp[--j] = static_cast<std::uint8_t>(mod);
+            }
+            if( !map_digits_sse2( dst, src, len, done ) ) {
+                return false;
+            }
+#endif
+            for( ; done<len; ++done ) {
+                int digit58 = ( src[done] < 128 ) ? index( src[done] ) : -1;
+                if( digit58 < 0 ) {
+                    return false;
                 }
+                dst[done] = static_cast<std::uint8_t>(digit58);
+            }
+            return true;
+        }
 
-                while(j<len && tmp[j]==0) ++j;
+        /// false if 'sources' is longer than max_encoded or not base58
+        template <typename U>
+        static
+        bool decode( decoded_buffer &out, const U *sources, size_t lens )
+        {
+            out.size = 0;
+            out.data[0] = '\0';
+            if( lens * sizeof(U) > max_encoded ) {
+                return false;
+            }
+            int res = decode( out.data, sources, lens );
+            if( res < 0 ) {
+                return false;
+            }
+            out.size = static_cast<size_t>(res);
+            return true;
+        }
 
-                memcpy( dst, &tmp[j-zc], len-(j-zc) );
+        /// Decodes exactly N bytes (see encode_fixed); false if 'src' is
+        /// not valid base58 or does not hold N bytes.
+        template <size_t N, typename U>
+        static
+        bool decode_fixed( std::uint8_t *dst, const U *sources, size_t lens )
+        {
+            using cu8 = const std::uint8_t;
+            using max_len = std::integral_constant<size_t, max_chars( N )>;
 
-                dst[ len - (j-zc) ] = '\0';
-                return static_cast<int>(len - (j-zc));
+            size_t len = lens * sizeof(U);
+            if( len > max_len::value ) {
+                return false;
             }
-            return 0;
+
+            std::uint8_t  digits[max_len::value];
+            std::uint32_t limbs[decoded_limbs( max_len::value )];
+            std::uint8_t  tmp[max_len::value + 1];
+            if( !map_digits( digits, reinterpret_cast<cu8 *>(sources), len ) ) {
+                return false;
+            }
+            int res = decode_limbs( tmp, digits, len, limbs,
+                                    std::integral_constant<size_t,
+                                            decoded_limbs( max_len::value )>( ) );
+            if( res != static_cast<int>(N) ) {
+                return false;
+            }
+            memcpy( dst, tmp, N );
+            return true;
         }
 
         template <typename U>
         static
         std::string decode( const U *data, size_t lens )
         {
-            std::string tmp( ( ( lens * sizeof(U)) / 4 * 3 + 3 ), 0);
+            decoded_buffer buf;
+            if( lens * sizeof(U) <= max_encoded ) {
+                return decode( buf, data, lens ) ? buf.str( ) : std::string( );
+            }
+
+            /// every character gives one byte at most; a run of '1's
+            /// gives exactly one each
+            std::string tmp( lens * sizeof(U) + 1, 0);
 
             using u8  = std::uint8_t;
             using cu8 = const std::uint8_t;
@@ -116,6 +205,11 @@ namespace bchain {
         static
         std::string encode( const std::string &src )
         {
+            encoded_buffer buf;
+            if( encode( buf, src.c_str( ), src.size( ) ) ) {
+                return buf.str( );
+            }
+
             using u8  = std::uint8_t;
             using cu8 = const std::uint8_t;
             std::string tmp(encoded_size( src.size( ) ), 0);
@@ -125,65 +219,72 @@ namespace bchain {
             return tmp;
         }
 
+        /// Payloads 25 (addresses), 37 and 38 (WIF) bytes long go to
+        /// encode_fixed; anything else to the run-time sized kernel.
         template <typename U>
         static
         size_t encode( std::uint8_t *dst, const U *sources, size_t lens )
         {
-
-            using  u8 =       std::uint8_t;
             using cu8 = const std::uint8_t;
 
             size_t len = lens * sizeof(U);
             const std::uint8_t * src = reinterpret_cast<cu8 *>(sources);
 
-            *dst = '\0';
-            if( len > 0 ) {
-
-                size_t tlen     = len * 2;
-                size_t j        = tlen;
-                int zc          = 0;
-                size_t start    = 0;
-                size_t mod      = 0;
-
-                auto copy_data = copy_of_range( src, 0, len );
-                std::uint8_t *copy = reinterpret_cast<u8 *>(&copy_data[0]);
-
-                std::vector<std::uint8_t> tmp(tlen);
-
-                while( (static_cast<size_t>(zc) < len) && (copy[zc] == '\0')) {
-                    ++zc;
-                }
-
-                start = static_cast<size_t>(zc);
-
-                while( start < len ) {
-
-                    mod = divmod58( copy, start, len );
-                    if( copy[start] == 0 ) {
-                        ++start;
-                    }
-                    tmp[--j] = static_cast<std::uint8_t>(code(mod));
-                }
-
-                while( (j < tlen) && (tmp[j] == code(0)) ) {
-                    ++j;
-                }
+            switch( len ) {
+            case 25:
+                return encode_fixed<25>( dst, src );
+            case 37:
+                return encode_fixed<37>( dst, src );
+            case 38:
+                return encode_fixed<38>( dst, src );
+            default:
+                break;
+            }
 
-                while( --zc >= 0 ) {
-                    tmp[--j] = static_cast<std::uint8_t>(code( 0 ));
-                }
+            if( len <= max_payload + 4 ) {
+                std::uint32_t limbs[encoded_limbs( max_payload + 4 )];
+                return encode_limbs( dst, src, len, limbs );
+            }
+            std::vector<std::uint32_t> limbs(encoded_limbs( len ) );
+            return encode_limbs( dst, src, len, &limbs[0] );
+        }
 
-                memcpy( dst, &tmp[j], tlen - j);
-                dst[tlen-j] = '\0';
-                return tlen - j;
+        /// false if 'sources' is longer than max_payload
+        template <typename U>
+        static
+        bool encode( encoded_buffer &out, const U *sources, size_t lens )
+        {
+            out.size = 0;
+            out.data[0] = '\0';
+            if( lens * sizeof(U) > max_payload ) {
+                return false;
             }
-            return 0;
+            out.size = encode( out.data, sources, lens );
+            return true;
+        }
+
+        /// N known at compile time: limb counts are constants and the
+        /// scratch lives on the stack, so the compiler can unroll the
+        /// packing and digit loops.
+        template <size_t N>
+        static
+        size_t encode_fixed( std::uint8_t *dst, const std::uint8_t *src )
+        {
+            std::uint32_t limbs[encoded_limbs( N )];
+            return encode_limbs( dst, src,
+                                 std::integral_constant<size_t, N>( ),
+                                 limbs );
         }
 
         template <typename U>
         static
         std::string encode( const U *sources, size_t lens )
         {
+            encoded_buffer buf;
+            if( encode( buf, sources, lens ) ) {
+                return buf.str( );
+            }
+
             size_t len = lens * sizeof(lens);
             std::string res( encoded_size( len ) + 1, '\0' );
             size_t enc = encode( reinterpret_cast<std::uint8_t *>(&res[0]),
@@ -196,9 +297,15 @@ namespace bchain {
         static
         std::string encode_check( const U *sources, size_t len )
         {
+            encoded_buffer buf;
+            if( encode_check( buf, sources, len ) ) {
+                return buf.str( );
+            }
+
             using u8  = std::uint8_t;
 
-            std::string res(encoded_size( len ) + 4, 0);
+            /// payload plus checksum, and the terminator encode writes
+            std::string res(encoded_size( len * sizeof(U) + 4 ) + 1, 0);
             size_t res_len = encode_check( reinterpret_cast<u8 *>(&res[0]),
                                            sources, len );
             res.resize( res_len );
@@ -206,6 +313,8 @@ namespace bchain {
         }
 
 
+        /// Payload and checksum are laid out in one buffer (on the stack
+        /// up to max_payload bytes) and encoded in a single pass.
         template <typename U>
         static
         size_t encode_check( std::uint8_t *dst, const U *sources, size_t lens )
@@ -215,46 +324,73 @@ namespace bchain {
             size_t len = lens * sizeof(U);
             auto src   = reinterpret_cast<cu8 *>(sources);
 
-            std::string tmp;
-
-            tmp.reserve( len + 4 );
-
-            tmp.assign( src, src + len );
-
-            tmp.resize( tmp.size( ) + 4 );
+            if( len <= max_payload ) {
+                std::uint8_t tmp[max_payload + 4];
+                memcpy( tmp, src, len );
+                append_checksum( tmp, len );
+                return encode( dst, tmp, len + 4 );
+            }
 
-            hash::hash256::digest_block digit;
-            hash::hash256::get( digit, sources, lens );
+            std::vector<std::uint8_t> tmp(src, src + len);
+            tmp.resize( len + 4 );
+            append_checksum( &tmp[0], len );
+            return encode( dst, &tmp[0], tmp.size( ) );
+        }
 
-            tmp[len + 0] = static_cast<char>( digit[0] );
-            tmp[len + 1] = static_cast<char>( digit[1] );
-            tmp[len + 2] = static_cast<char>( digit[2] );
-            tmp[len + 3] = static_cast<char>( digit[3] );
+        /// false if 'sources' is longer than max_payload
+        template <typename U>
+        static
+        bool encode_check( encoded_buffer &out, const U *sources, size_t lens )
+        {
+            out.size = 0;
+            out.data[0] = '\0';
+            if( lens * sizeof(U) > max_payload ) {
+                return false;
+            }
+            out.size = encode_check( out.data, sources, lens );
+            return true;
+        }
 
-            return encode( dst, tmp.c_str( ), tmp.size( ) );
+        /// Decodes into 'out', checks the trailing four bytes against the
+        /// double SHA-256 of the rest in place and drops them. False for
+        /// bad characters, strings longer than max_encoded, short input or
+        /// a wrong checksum; 'out' holds whatever was decoded then.
+        template <typename U>
+        static
+        bool decode_check( decoded_buffer &out, const U *src, size_t len )
+        {
+            if( !decode( out, src, len ) || out.size < 4 ) {
+                return false;
+            }
+            out.size -= 4;
+            bool valid = check_tail( out.data, out.size );
+            out.data[out.size] = '\0';
+            return valid;
         }
 
         template <typename U>
         static
         std::pair<std::string, bool> decode_check( const U *src, size_t len )
         {
-            using u8 = std::uint8_t;
-            auto dec = decode( src, len );
+            std::string dec;
+
+            if( len * sizeof(U) <= max_encoded ) {
+                decoded_buffer buf;
+                if( decode( buf, src, len ) ) {
+                    dec.assign( buf.c_str( ), buf.size );
+                }
+            } else {
+                dec = decode( src, len );
+            }
 
             if( dec.size( ) < 4 ) {
                 return std::make_pair(dec, false);
             }
 
-            hash::hash256::digest_block digit;
-
             auto body_len = dec.size( ) - 4;
-
-            hash::hash256::get(digit, dec.c_str( ), body_len );
-
-            bool valid = static_cast<u8>(dec[body_len + 0]) == digit[0]
-                      && static_cast<u8>(dec[body_len + 1]) == digit[1]
-                      && static_cast<u8>(dec[body_len + 2]) == digit[2]
-                      && static_cast<u8>(dec[body_len + 3]) == digit[3];
+            bool valid = check_tail(
+                        reinterpret_cast<const std::uint8_t *>(dec.c_str( )),
+                        body_len );
 
             dec.resize(body_len);
             return std::make_pair(dec, valid);
@@ -268,13 +404,258 @@ namespace bchain {
 
     private:
 
+        /// writes the first four bytes of hash256( data[0..len) ) after it
+        static
+        void append_checksum( std::uint8_t *data, size_t len )
+        {
+            hash::hash256::digest_block digit;
+            hash::hash256::get( digit, data, len );
+            memcpy( data + len, digit, 4 );
+        }
+
+        /// the four bytes after data[0..len) are its checksum
+        static
+        bool check_tail( const std::uint8_t *data, size_t len )
+        {
+            hash::hash256::digest_block digit;
+            hash::hash256::get( digit, data, len );
+            return memcmp( data + len, digit, 4 ) == 0;
+        }
+
+        /// 58^5, the largest power of 58 below 2^32
+        enum { radix        = 656356768 };
+        enum { radix_digits = 5 };
+
+        /// base 2^32 limbs for a 'len'-byte input, plus one for the
+        /// radix-58^5 accumulator (29.29 bits per limb, 29 taken)
+        static constexpr
+        size_t encoded_limbs( size_t len )
+        {
+            return ( len * 8 + 28 ) / 29 + 1;
+        }
+
+        /// base 2^32 limbs for 'len' digits (5.86 bits each, 6 taken)
+        static constexpr
+        size_t decoded_limbs( size_t len )
+        {
+            return ( len * 6 + 31 ) / 32 + 1;
+        }
+
+        /// longest encoding of an N-byte payload: log58(256) < 1.3658
+        static constexpr
+        size_t max_chars( size_t n )
+        {
+            return n * 13658 / 10000 + 1;
+        }
+
+        /// Big-endian bytes to base 58. The input is read as 32-bit limbs
+        /// and folded into radix-58^5 limbs (little-endian), so one 64-bit
+        /// multiply-divide step covers four input bytes and five output
+        /// digits. 'out' needs encoded_limbs( len ) entries. 'Len' is
+        /// size_t or an integral_constant for the fixed kernels.
+        template <typename Len>
         static
-        std::string copy_of_range( const std::uint8_t *src,
-                                   size_t from, size_t to )
+        size_t encode_limbs( std::uint8_t *dst, const std::uint8_t *src,
+                             Len len, std::uint32_t *out )
         {
-            return std::string( &src[from], &src[to] );
+            size_t zc = 0;
+            while( zc < len && src[zc] == 0 ) {
+                ++zc;
+            }
+
+            size_t used = 0;
+            size_t pos  = 0;
+            const size_t head = ( len % 4 ) ? ( len % 4 ) : 4;
+            const size_t count = ( len + 3 ) / 4;
+
+            for( size_t k=0; k<count; ++k ) {
+                std::uint32_t limb = 0;
+                for( size_t b=0; b<( k ? 4 : head ); ++b ) {
+                    limb = ( limb << 8 ) | src[pos++];
+                }
+                std::uint64_t carry = limb;
+                for( size_t i=0; i<used; ++i ) {
+                    std::uint64_t t = ( std::uint64_t(out[i]) << 32 ) + carry;
+                    out[i] = static_cast<std::uint32_t>(t % radix);
+                    carry  = t / radix;
+                }
+                while( carry ) {
+                    out[used++] = static_cast<std::uint32_t>(carry % radix);
+                    carry /= radix;
+                }
+            }
+
+            std::uint8_t *p = dst;
+            for( size_t i=0; i<zc; ++i ) {
+                *p++ = static_cast<std::uint8_t>(code( 0 ));
+            }
+
+            bool leading = true;
+            for( size_t i=used; i-- > 0; ) {
+                std::uint32_t v = out[i];
+                std::uint8_t digits[radix_digits];
+                for( size_t j=radix_digits; j-- > 0; ) {
+                    digits[j] = static_cast<std::uint8_t>(v % 58);
+                    v /= 58;
+                }
+                for( size_t j=0; j<radix_digits; ++j ) {
+                    if( leading && digits[j] == 0 ) {
+                        continue;
+                    }
+                    leading = false;
+                    *p++ = static_cast<std::uint8_t>(code( digits[j] ));
+                }
+            }
+            *p = '\0';
+            return static_cast<size_t>(p - dst);
         }
 
+        /// Digit values (map_digits) to big-endian bytes, the other way
+        /// round: digits are taken five at a time and multiplied into
+        /// base 2^32 limbs. -1 if the value needs more than 'cap' limbs.
+        template <typename Len, typename Cap>
+        static
+        int decode_limbs( std::uint8_t *dst, const std::uint8_t *digits,
+                          Len len, std::uint32_t *out, Cap cap )
+        {
+            *dst = '\0';
+
+            size_t zc = 0;
+            while( zc < len && digits[zc] == 0 ) {
+                ++zc;
+            }
+
+            size_t used = 0;
+            size_t pos  = zc;
+            const size_t head = ( ( len - zc ) % radix_digits )
+                              ? ( ( len - zc ) % radix_digits )
+                              : size_t(radix_digits);
+
+            while( pos < len ) {
+                const size_t take = ( pos == zc ) ? head : size_t(radix_digits);
+                std::uint32_t chunk = 0;
+                std::uint32_t mult  = 1;
+                for( size_t b=0; b<take; ++b, ++pos ) {
+                    chunk = chunk * 58 + digits[pos];
+                    mult *= 58;
+                }
+                std::uint64_t carry = chunk;
+                for( size_t i=0; i<used; ++i ) {
+                    std::uint64_t t = std::uint64_t(out[i]) * mult + carry;
+                    out[i] = static_cast<std::uint32_t>(t);
+                    carry  = t >> 32;
+                }
+                while( carry ) {
+                    if( used == cap ) {
+                        return -1;
+                    }
+                    out[used++] = static_cast<std::uint32_t>(carry);
+                    carry >>= 32;
+                }
+            }
+
+            std::uint8_t *p = dst;
+            memset( p, 0, zc );
+            p += zc;
+
+            bool leading = true;
+            for( size_t i=used; i-- > 0; ) {
+                for( int j=24; j>=0; j-=8 ) {
+                    auto byte = static_cast<std::uint8_t>(out[i] >> j);
+                    if( leading && byte == 0 ) {
+                        continue;
+                    }
+                    leading = false;
+                    *p++ = byte;
+                }
+            }
+            *p = '\0';
+            return static_cast<int>(p - dst);
+        }
+
+#ifdef BITCHAIN_BASE58_X86
+
+        /// The alphabet is six runs of consecutive characters; a digit is
+        /// the character minus its run's offset. Bytes above 0x7F compare
+        /// negative and fall in no run.
+        struct alphabet_run {
+            char lo;
+            char hi;
+            char offset;
+        };
+
+        static
+        const alphabet_run *alphabet_runs( )
+        {
+            static const alphabet_run runs[6] = {
+                { '1', '9', 49 }, { 'A', 'H', 56 }, { 'J', 'N', 57 },
+                { 'P', 'Z', 58 }, { 'a', 'k', 64 }, { 'm', 'z', 65 },
+            };
+            return runs;
+        }
+
+        /// whole 16-byte blocks from 'done' on; 'done' is left at the
+        /// first block not mapped
+        __attribute__((target("sse2")))
+        static
+        bool map_digits_sse2( std::uint8_t *dst, const std::uint8_t *src,
+                              size_t len, size_t &done )
+        {
+            const alphabet_run *runs = alphabet_runs( );
+            for( ; done + 16 <= len; done += 16 ) {
+                __m128i c   = _mm_loadu_si128(
+                                reinterpret_cast<const __m128i *>(src + done) );
+                __m128i ok  = _mm_setzero_si128( );
+                __m128i sub = _mm_setzero_si128( );
+                for( int r=0; r<6; ++r ) {
+                    __m128i in = _mm_and_si128(
+                        _mm_cmpgt_epi8( c, _mm_set1_epi8( runs[r].lo - 1 ) ),
+                        _mm_cmpgt_epi8( _mm_set1_epi8( runs[r].hi + 1 ), c ) );
+                    ok  = _mm_or_si128( ok, in );
+                    sub = _mm_or_si128( sub, _mm_and_si128( in,
+                                        _mm_set1_epi8( runs[r].offset ) ) );
+                }
+                if( _mm_movemask_epi8( ok ) != 0xFFFF ) {
+                    return false;
+                }
+                _mm_storeu_si128( reinterpret_cast<__m128i *>(dst + done),
+                                  _mm_sub_epi8( c, sub ) );
+            }
+            return true;
+        }
+
+        __attribute__((target("avx2")))
+        static
+        bool map_digits_avx2( std::uint8_t *dst, const std::uint8_t *src,
+                              size_t len, size_t &done )
+        {
+            const alphabet_run *runs = alphabet_runs( );
+            for( ; done + 32 <= len; done += 32 ) {
+                __m256i c   = _mm256_loadu_si256(
+                                reinterpret_cast<const __m256i *>(src + done) );
+                __m256i ok  = _mm256_setzero_si256( );
+                __m256i sub = _mm256_setzero_si256( );
+                for( int r=0; r<6; ++r ) {
+                    __m256i in = _mm256_and_si256(
+                        _mm256_cmpgt_epi8( c,
+                                           _mm256_set1_epi8( runs[r].lo - 1 ) ),
+                        _mm256_cmpgt_epi8( _mm256_set1_epi8( runs[r].hi + 1 ),
+                                           c ) );
+                    ok  = _mm256_or_si256( ok, in );
+                    sub = _mm256_or_si256( sub, _mm256_and_si256( in,
+                                        _mm256_set1_epi8( runs[r].offset ) ) );
+                }
+                if( _mm256_movemask_epi8( ok ) != -1 ) {
+                    return false;
+                }
+                _mm256_storeu_si256( reinterpret_cast<__m256i *>(dst + done),
+                                     _mm256_sub_epi8( c, sub ) );
+            }
+            return true;
+        }
+
+#endif
+
         static
         char index( size_t id )
         {
@@ -308,39 +689,6 @@ namespace bchain {
                                         "abcdefghijkmnopqrstuvwxyz";
             return table[id % 58];
         }
-
-        static
-        std::uint8_t divmod58( std::uint8_t *num256, size_t start, size_t len )
-        {
-            std::uint32_t dig256;
-            std::uint32_t tmp;
-            std::uint32_t rem = 0;
-
-            for( size_t i = start; i<len; i++ ) {
-                dig256    = static_cast<std::uint32_t>( num256[i] & 0xFF );
-                tmp       = rem * 256 + dig256;
-                num256[i] = static_cast<std::uint8_t>( tmp / 58 );
-                rem       = tmp % 58;
-            }
-
-            return static_cast<std::uint8_t>(rem & 0xFF);
-        }
-
-        static
-        std::uint8_t divmod256( std::uint8_t *num58, size_t start, size_t len )
-        {
-            std::uint32_t dig58;
-            std::uint32_t tmp;
-            std::uint32_t rem = 0;
-
-            for(size_t i=start; i < len; i++) {
-                dig58    = static_cast<uint32_t>( num58[i] & 0xFF );
-                tmp      = rem * 58 + dig58;
-                num58[i] = static_cast<std::uint8_t>( tmp / 256 );
-                rem      = tmp % 256;
-            }
-            return static_cast<std::uint8_t>(rem);
-        }
     };
 }
 
@@ -0,0 +1,90 @@
+#include <iostream>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "openssl/sha.h"
+
+#include "hash.h"
+
+using namespace bchain;
+
+namespace {
+
+    using clock_type = std::chrono::steady_clock;
+
+    /// hash256 as it was before the fixed-size kernels: two full
+    /// SHA256_Init/Update/Final passes.
+    void hash256_openssl( std::uint8_t *dst, const std::uint8_t *src,
+                          std::size_t len )
+    {
+        SHA256_CTX ctx;
+        SHA256_Init( &ctx );
+        SHA256_Update( &ctx, src, len );
+        SHA256_Final( dst, &ctx );
+        SHA256_Init( &ctx );
+        SHA256_Update( &ctx, dst, SHA256_DIGEST_LENGTH );
+        SHA256_Final( dst, &ctx );
+    }
+
+    template <typename Func>
+    double measure( std::size_t rounds, Func call )
+    {
+        auto start = clock_type::now( );
+        for( std::size_t i=0; i<rounds; ++i ) {
+            call( );
+        }
+        std::chrono::duration<double, std::nano> spent =
+                clock_type::now( ) - start;
+        return spent.count( ) / static_cast<double>(rounds);
+    }
+
+    template <std::size_t Len>
+    void bench_size( std::size_t rounds )
+    {
+        std::uint8_t data[Len];
+        std::uint8_t dst[hash::hash256::digest_length] = { 0 };
+
+        for( std::size_t i=0; i<Len; ++i ) {
+            data[i] = static_cast<std::uint8_t>(i * 7);
+        }
+
+        /// feed the previous digest back in so nothing gets hoisted
+        auto old_path = measure( rounds, [&]( ) {
+            data[0] ^= dst[0];
+            hash256_openssl( dst, data, Len );
+        } );
+
+        auto fixed_path = measure( rounds, [&]( ) {
+            data[0] ^= dst[0];
+            hash::hash256::get( dst, data );
+        } );
+
+        auto runtime_path = measure( rounds, [&]( ) {
+            data[0] ^= dst[0];
+            hash::hash256::get( dst, &data[0], Len );
+        } );
+
+        hash::hash256::get( dst, data );
+        std::uint8_t verify[hash::hash256::digest_length];
+        hash256_openssl( verify, data, Len );
+
+        std::cout << "hash256/" << Len << ":"
+                  << " openssl " << old_path << " ns,"
+                  << " fixed " << fixed_path << " ns,"
+                  << " runtime " << runtime_path << " ns"
+                  << ( memcmp( dst, verify, sizeof(dst) ) ? " MISMATCH" : "" )
+                  << "\n";
+    }
+}
+
+int main_bench_hash( )
+{
+    const std::size_t rounds = 1000000;
+
+    bench_size<32>( rounds );
+    bench_size<64>( rounds );
+    bench_size<80>( rounds );
+
+    return 0;
+}
@@ -0,0 +1,685 @@
+#ifndef BLOCK_CHAIN_BIP32_H
+#define BLOCK_CHAIN_BIP32_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <array>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <memory.h>
+
+#include "crypto.h"
+#include "hash.h"
+#include "base58.h"
+#include "address.h"
+#include "thread_pool.h"
+
+namespace bchain { namespace crypto {
+
+    /// BIP32 extended key: a secp256k1 key and its chain code, with the
+    /// position it was derived at.
+    struct extended_key {
+
+        std::uint8_t                  depth = 0;
+        std::array<std::uint8_t, 4>   parent_fingerprint {{ 0, 0, 0, 0 }};
+        std::uint32_t                 child = 0;
+        std::array<std::uint8_t, 32>  chain {{ }};
+
+        /// 0x00 || private key, or a compressed public key, as
+        /// serialized
+        std::array<std::uint8_t, 33>  key {{ }};
+
+        extended_key( ) = default;
+        extended_key( const extended_key & ) = default;
+        extended_key &operator = ( const extended_key & ) = default;
+
+        ~extended_key( )
+        {
+            OPENSSL_cleanse( key.data( ), key.size( ) );
+        }
+
+        bool is_private( ) const
+        {
+            return key[0] == 0;
+        }
+
+        const std::uint8_t *private_bytes( ) const
+        {
+            return key.data( ) + 1;
+        }
+
+        /// private keys get a compressed public conversion form
+        ec_key get_key( ) const
+        {
+            if( !is_private( ) ) {
+                return ec_key::create_public( key.data( ), key.size( ) );
+            }
+            auto res = ec_key::create_private( private_bytes( ), 32 );
+            if( res ) {
+                res.set_conv_compressed( true );
+            }
+            return res;
+        }
+    };
+
+    /// BIP32 derivation. Child keys come from HMAC-SHA512 over the parent
+    /// chain code; the keyed midstate is built once per parent, so every
+    /// child costs the two compressions of its 37-byte message.
+    struct bip32 {
+
+        enum : std::uint32_t { hardened = 0x80000000u };
+
+        enum : std::uint32_t {
+            VERSION_MAINNET_PUBLIC  = 0x0488B21E,
+            VERSION_MAINNET_PRIVATE = 0x0488ADE4,
+            VERSION_TESTNET_PUBLIC  = 0x043587CF,
+            VERSION_TESTNET_PRIVATE = 0x04358394,
+        };
+
+        /// version, depth, fingerprint, child, chain code, key
+        enum { serialized_size = 4 + 1 + 4 + 4 + 32 + 33 };
+
+        /// children handed to a single worker by the range calls
+        enum { range_grain = ec_key::derive_grain };
+
+        /// Master key from a seed (BIP32 suggests 16 to 64 bytes). False
+        /// for the one in 2^127 seeds that give an invalid key.
+        static
+        bool from_seed( extended_key &out, const std::uint8_t *seed,
+                        size_t len )
+        {
+            static const char salt[] = "Bitcoin seed";
+            hash::hmac_sha512 mac( reinterpret_cast<const std::uint8_t *>(salt),
+                                   sizeof(salt) - 1 );
+            hash::hmac_sha512::digest_block i;
+            mac.get( i, seed, len );
+
+            bool res = valid_scalar( i );
+            if( res ) {
+                out = extended_key( );
+                out.key[0] = 0;
+                memcpy( &out.key[1], i, 32 );
+                memcpy( out.chain.data( ), i + 32, 32 );
+            }
+            OPENSSL_cleanse( i, sizeof(i) );
+            return res;
+        }
+
+        /// compressed public key of either kind of extended key
+        static
+        bool public_key( std::uint8_t *out, const extended_key &k )
+        {
+            if( !k.is_private( ) ) {
+                memcpy( out, k.key.data( ), k.key.size( ) );
+                return true;
+            }
+            return ec_key::derive_public_many( k.private_bytes( ), 1, out,
+                                               true );
+        }
+
+        /// the public half of 'k'
+        static
+        bool neuter( extended_key &out, const extended_key &k )
+        {
+            std::uint8_t pub[33];
+            if( !public_key( pub, k ) ) {
+                return false;
+            }
+            out = k;
+            memcpy( out.key.data( ), pub, sizeof(pub) );
+            return true;
+        }
+
+        /// False for a hardened index under a public parent and for the
+        /// one in 2^127 indexes that give no valid key; BIP32 moves on
+        /// to the next index then.
+        static
+        bool derive_child( extended_key &out, const extended_key &parent,
+                           std::uint32_t index )
+        {
+            parent_state ps;
+            if( !ps.init( parent ) ) {
+                return false;
+            }
+            return derive_chunk( ps, index, 1, &out, nullptr );
+        }
+
+        static
+        bool derive_path( extended_key &out, const extended_key &root,
+                          const std::vector<std::uint32_t> &path )
+        {
+            extended_key cur(root);
+            for( auto idx: path ) {
+                extended_key next;
+                if( !derive_child( next, cur, idx ) ) {
+                    return false;
+                }
+                cur = next;
+            }
+            out = cur;
+            return true;
+        }
+
+        /// "m/44'/0'/0'/0" style; "h" or "H" mark hardened indexes too
+        static
+        bool parse_path( std::vector<std::uint32_t> &out,
+                         const std::string &path )
+        {
+            out.clear( );
+            if( path.empty( ) || ( path[0] != 'm' && path[0] != 'M' ) ) {
+                return false;
+            }
+            size_t pos = 1;
+            while( pos < path.size( ) ) {
+                if( path[pos] != '/' ) {
+                    return false;
+                }
+                ++pos;
+                std::uint64_t val = 0;
+                size_t        digits = 0;
+                while( pos < path.size( ) && path[pos] >= '0'
+                                          && path[pos] <= '9' )
+                {
+                    val = val * 10 + static_cast<unsigned>(path[pos] - '0');
+                    if( val >= hardened ) {
+                        return false;
+                    }
+                    ++pos;
+                    ++digits;
+                }
+                if( digits == 0 ) {
+                    return false;
+                }
+                if( pos < path.size( ) && ( path[pos] == '\'' ||
+                                            path[pos] == 'h' ||
+                                            path[pos] == 'H' ) )
+                {
+                    val |= hardened;
+                    ++pos;
+                }
+                out.push_back( static_cast<std::uint32_t>(val) );
+            }
+            return true;
+        }
+
+        /// xprv/xpub (tprv/tpub on testnet)
+        static
+        std::string encode( const extended_key &k, bool testnet = false )
+        {
+            std::uint32_t ver = k.is_private( )
+                    ? ( testnet ? VERSION_TESTNET_PRIVATE
+                                : VERSION_MAINNET_PRIVATE )
+                    : ( testnet ? VERSION_TESTNET_PUBLIC
+                                : VERSION_MAINNET_PUBLIC );
+
+            std::uint8_t buf[serialized_size];
+            put_be32( buf, ver );
+            buf[4] = k.depth;
+            memcpy( buf + 5, k.parent_fingerprint.data( ), 4 );
+            put_be32( buf + 9, k.child );
+            memcpy( buf + 13, k.chain.data( ), 32 );
+            memcpy( buf + 45, k.key.data( ), 33 );
+
+            auto res = base58::encode_check( buf, sizeof(buf) );
+            OPENSSL_cleanse( buf, sizeof(buf) );
+            return res;
+        }
+
+        /// Either network; the key itself is checked too.
+        static
+        bool decode( extended_key &out, const std::string &s )
+        {
+            base58::decoded_buffer buf;
+            bool res = base58::decode_check( buf, s.c_str( ), s.size( ) )
+                    && buf.size == serialized_size;
+            if( res ) {
+                std::uint32_t ver = get_be32( buf.data );
+                bool priv = ver == VERSION_MAINNET_PRIVATE
+                         || ver == VERSION_TESTNET_PRIVATE;
+                bool pub  = ver == VERSION_MAINNET_PUBLIC
+                         || ver == VERSION_TESTNET_PUBLIC;
+
+                extended_key k;
+                k.depth = buf.data[4];
+                memcpy( k.parent_fingerprint.data( ), buf.data + 5, 4 );
+                k.child = get_be32( buf.data + 9 );
+                memcpy( k.chain.data( ), buf.data + 13, 32 );
+                memcpy( k.key.data( ), buf.data + 45, 33 );
+
+                if( priv ) {
+                    res = k.key[0] == 0 && valid_scalar( k.private_bytes( ) );
+                } else if( pub ) {
+                    res = ( k.key[0] == 2 || k.key[0] == 3 )
+                       && ec_key::create_public( k.key.data( ), 33 );
+                } else {
+                    res = false;
+                }
+                if( res && k.depth == 0 ) {
+                    static const std::uint8_t none[4] = { 0 };
+                    res = k.child == 0 &&
+                          memcmp( k.parent_fingerprint.data( ), none, 4 ) == 0;
+                }
+                if( res ) {
+                    out = k;
+                }
+            }
+            OPENSSL_cleanse( buf.data, sizeof(buf.data) );
+            return res;
+        }
+
+        /// Children first .. first + count - 1 of 'parent' into 'out',
+        /// fanned out over the pool. Private parents give private
+        /// children. False if any index failed; its slot is left
+        /// default (all zero key).
+        static
+        bool derive_range( const extended_key &parent, std::uint32_t first,
+                           std::size_t count, extended_key *out,
+                           thread_pool *pool = nullptr )
+        {
+            return run_range( parent, first, count, out, nullptr, pool );
+        }
+
+        /// Only the compressed public keys, 33 bytes each, back to back;
+        /// ready for address::p2pkh::create_many. Failed slots are zeroed.
+        static
+        bool derive_public_range( const extended_key &parent,
+                                  std::uint32_t first, std::size_t count,
+                                  std::uint8_t *out,
+                                  thread_pool *pool = nullptr )
+        {
+            return run_range( parent, first, count, nullptr, out, pool );
+        }
+
+        /// P2PKH addresses of the children; failed ones are empty.
+        static
+        address::address_list derive_addresses( const extended_key &parent,
+                                                std::uint32_t first,
+                                                std::size_t count,
+                                                std::uint8_t prefix,
+                                                thread_pool *pool = nullptr )
+        {
+            std::vector<std::uint8_t> pubs(count * 33);
+            derive_public_range( parent, first, count, pubs.data( ), pool );
+            return address::p2pkh::create_many( pubs.data( ), 33, count,
+                                                prefix, pool );
+        }
+
+        /// Remembers every node on the paths it derived, so accounts and
+        /// chains under the same root are derived once.
+        class path_cache {
+
+        public:
+
+            explicit path_cache( const extended_key &root )
+                :root_(root)
+            { }
+
+            path_cache( const path_cache & ) = delete;
+            path_cache &operator = ( const path_cache & ) = delete;
+
+            bool derive( extended_key &out, const std::string &path )
+            {
+                std::vector<std::uint32_t> p;
+                return parse_path( p, path ) && derive( out, p );
+            }
+
+            /// Starts from the longest cached prefix of 'path'; the lock
+            /// is not held while deriving.
+            bool derive( extended_key &out,
+                         const std::vector<std::uint32_t> &path )
+            {
+                std::vector<std::uint32_t> key(path);
+                extended_key cur;
+                {
+                    std::lock_guard<std::mutex> lck(lock_);
+                    while( !key.empty( ) ) {
+                        auto f = nodes_.find( key );
+                        if( f != nodes_.end( ) ) {
+                            cur = f->second;
+                            break;
+                        }
+                        key.pop_back( );
+                    }
+                    if( key.empty( ) ) {
+                        cur = root_;
+                    }
+                }
+
+                std::vector<std::pair<std::vector<std::uint32_t>,
+                                      extended_key> > made;
+                for( size_t i=key.size( ); i<path.size( ); ++i ) {
+                    extended_key next;
+                    if( !derive_child( next, cur, path[i] ) ) {
+                        return false;
+                    }
+                    key.push_back( path[i] );
+                    made.emplace_back( key, next );
+                    cur = next;
+                }
+
+                if( !made.empty( ) ) {
+                    std::lock_guard<std::mutex> lck(lock_);
+                    for( auto &m: made ) {
+                        nodes_.emplace( m.first, m.second );
+                    }
+                }
+                out = cur;
+                return true;
+            }
+
+            std::size_t size( ) const
+            {
+                std::lock_guard<std::mutex> lck(lock_);
+                return nodes_.size( );
+            }
+
+            void clear( )
+            {
+                std::lock_guard<std::mutex> lck(lock_);
+                nodes_.clear( );
+            }
+
+        private:
+            mutable std::mutex  lock_;
+            extended_key        root_;
+            std::map<std::vector<std::uint32_t>, extended_key> nodes_;
+        };
+
+    private:
+
+        /// What every child of one parent shares.
+        struct parent_state {
+
+            bool init( const extended_key &k )
+            {
+                key = &k;
+                if( !public_key( pub, k ) ) {
+                    return false;
+                }
+                hash::hash160::digest_block id;
+                hash::hash160::get( id, pub, sizeof(pub) );
+                memcpy( fingerprint, id, sizeof(fingerprint) );
+                mac.set_key( k.chain.data( ), k.chain.size( ) );
+                return true;
+            }
+
+            const extended_key *key = nullptr;
+            std::uint8_t        pub[33];
+            std::uint8_t        fingerprint[4];
+            hash::hmac_sha512   mac;
+        };
+
+        static
+        bool run_range( const extended_key &parent, std::uint32_t first,
+                        std::size_t count, extended_key *keys,
+                        std::uint8_t *pubs, thread_pool *pool )
+        {
+            if( count == 0 ) {
+                return true;
+            }
+            if( count - 1 > 0xFFFFFFFFu - first ) {
+                return false;
+            }
+            parent_state ps;
+            if( !ps.init( parent ) ) {
+                return false;
+            }
+
+            std::atomic<bool> ok(true);
+            thread_pool &tp = pool ? *pool : thread_pool::common( );
+
+            tp.parallel_for( count, range_grain,
+                [&]( std::size_t b, std::size_t e ) {
+                    for( ; b<e; b+=range_grain ) {
+                        std::size_t n = ( e - b < range_grain )
+                                      ? e - b : std::size_t(range_grain);
+                        if( !derive_chunk( ps, first + std::uint32_t(b), n,
+                                           keys ? keys + b : nullptr,
+                                           pubs ? pubs + b * 33 : nullptr ) )
+                        {
+                            ok = false;
+                        }
+                    }
+                } );
+            return ok;
+        }
+
+        /// Children index .. index + n - 1 (n <= range_grain). Stages:
+        /// HMAC for each child, scalar tweak, then one batched public
+        /// key pass for the whole chunk.
+        static
+        bool derive_chunk( const parent_state &ps, std::uint32_t index,
+                           std::size_t n, extended_key *keys,
+                           std::uint8_t *pubs )
+        {
+            const bool priv = ps.key->is_private( );
+
+            std::uint8_t il[range_grain][32];
+            std::uint8_t ir[range_grain][32];
+            bool         good[range_grain];
+            bool         res = true;
+
+            for( std::size_t i=0; i<n; ++i ) {
+                std::uint32_t idx = index + std::uint32_t(i);
+                std::uint8_t  data[33 + 4];
+                good[i] = priv || !( idx & hardened );
+                if( idx & hardened ) {
+                    memcpy( data, ps.key->key.data( ), 33 );
+                } else {
+                    memcpy( data, ps.pub, 33 );
+                }
+                put_be32( data + 33, idx );
+
+                hash::hmac_sha512::digest_block out;
+                ps.mac.get( out, data, sizeof(data) );
+                memcpy( il[i], out, 32 );
+                memcpy( ir[i], out + 32, 32 );
+                OPENSSL_cleanse( out, sizeof(out) );
+                OPENSSL_cleanse( data, sizeof(data) );
+            }
+
+            /// private children: k_i = IL + k mod n; public keys from them
+            std::uint8_t child_pub[range_grain][33];
+            if( priv ) {
+                bn_ctx ctx;
+                for( std::size_t i=0; i<n; ++i ) {
+                    good[i] = good[i] &&
+                              add_scalar( il[i], il[i], ps.key->private_bytes( ),
+                                          ctx.get( ) );
+                }
+                if( pubs ) {
+                    /// failed slots come back zeroed; 'good' has them
+                    ec_key::derive_public_many( il[0], n, child_pub[0], true );
+                }
+            } else {
+                for( std::size_t i=0; i<n; ++i ) {
+                    good[i] = good[i] && valid_tweak( il[i] );
+                }
+                res = tweak_public( ps.pub, il[0], good, n, child_pub[0] );
+            }
+
+            for( std::size_t i=0; i<n; ++i ) {
+                res = res && good[i];
+                if( pubs ) {
+                    if( good[i] ) {
+                        memcpy( pubs + i * 33, child_pub[i], 33 );
+                    } else {
+                        memset( pubs + i * 33, 0, 33 );
+                    }
+                }
+                if( keys ) {
+                    extended_key &k = keys[i];
+                    k = extended_key( );
+                    if( !good[i] ) {
+                        continue;
+                    }
+                    k.depth = static_cast<std::uint8_t>(ps.key->depth + 1);
+                    memcpy( k.parent_fingerprint.data( ), ps.fingerprint, 4 );
+                    k.child = index + std::uint32_t(i);
+                    memcpy( k.chain.data( ), ir[i], 32 );
+                    if( priv ) {
+                        k.key[0] = 0;
+                        memcpy( &k.key[1], il[i], 32 );
+                    } else {
+                        memcpy( k.key.data( ), child_pub[i], 33 );
+                    }
+                }
+            }
+            OPENSSL_cleanse( il, sizeof(il) );
+            OPENSSL_cleanse( ir, sizeof(ir) );
+            return res;
+        }
+
+        static
+        const BIGNUM *order( )
+        {
+            return EC_GROUP_get0_order( curve::secp256k1( ) );
+        }
+
+        /// 0 < v < n
+        static
+        bool valid_scalar( const std::uint8_t *v )
+        {
+            bignum b;
+            bool res = b && order( )
+                    && BN_bin2bn( v, 32, b.get( ) )
+                    && !BN_is_zero( b.get( ) )
+                    && BN_cmp( b.get( ), order( ) ) < 0;
+            if( b ) {
+                BN_clear( b.get( ) );
+            }
+            return res;
+        }
+
+        /// v < n
+        static
+        bool valid_tweak( const std::uint8_t *v )
+        {
+            bignum b;
+            return b && order( )
+                && BN_bin2bn( v, 32, b.get( ) )
+                && BN_cmp( b.get( ), order( ) ) < 0;
+        }
+
+        /// out = il + k mod n; false if il >= n or the sum is zero
+        static
+        bool add_scalar( std::uint8_t *out, const std::uint8_t *il,
+                         const std::uint8_t *k, BN_CTX *ctx )
+        {
+            bignum a;
+            bignum b;
+            bool res = a && b && order( ) && ctx
+                    && BN_bin2bn( il, 32, a.get( ) )
+                    && BN_cmp( a.get( ), order( ) ) < 0
+                    && BN_bin2bn( k, 32, b.get( ) )
+                    && 1 == BN_mod_add( a.get( ), a.get( ), b.get( ), order( ),
+                                        ctx )
+                    && !BN_is_zero( a.get( ) )
+                    && 32 == BN_bn2binpad( a.get( ), out, 32 );
+            if( a ) {
+                BN_clear( a.get( ) );
+            }
+            if( b ) {
+                BN_clear( b.get( ) );
+            }
+            return res;
+        }
+
+        /// out_i = pub + tweak_i * G, compressed, for the 'good' tweaks;
+        /// one that reaches infinity clears its flag
+        static
+        bool tweak_public( const std::uint8_t *pub, const std::uint8_t *tweaks,
+                           bool *good, std::size_t n, std::uint8_t *out )
+        {
+#if defined(BITCHAIN_NATIVE_SECP256K1)
+            secp256k1::ge parent;
+            if( !secp256k1::ge::parse( parent, pub, 33 ) ) {
+                return false;
+            }
+            std::vector<secp256k1::gej> jac(n);
+            std::vector<secp256k1::ge>  aff(n);
+            for( std::size_t i=0; i<n; ++i ) {
+                secp256k1::scalar t;
+                if( !good[i] || !secp256k1::scalar::set_bytes( t, tweaks + i * 32 ) ) {
+                    good[i] = false;
+                    jac[i]  = secp256k1::gej::inf( );
+                    continue;
+                }
+                jac[i] = secp256k1::gej::add_ge( secp256k1::ecmult::gen( t ),
+                                                 parent );
+            }
+            secp256k1::points::to_affine( jac.data( ), n, aff.data( ) );
+            for( std::size_t i=0; i<n; ++i ) {
+                if( aff[i].infinity ) {
+                    good[i] = false;
+                    memset( out + i * 33, 0, 33 );
+                } else {
+                    aff[i].serialize( out + i * 33, true );
+                }
+            }
+            return true;
+#else
+            const EC_GROUP *group = curve::secp256k1( );
+            bn_ctx          ctx;
+            bignum          t;
+            bignum          one;
+            ec_point        parent(group);
+            if( !group || !ctx || !t || !one || !parent ||
+                1 != BN_one( one.get( ) ) ||
+                1 != EC_POINT_oct2point( group, parent.get( ), pub, 33,
+                                         ctx.get( ) ) )
+            {
+                return false;
+            }
+
+            std::vector<ec_point>   pts;
+            std::vector<EC_POINT *> raw(n, nullptr);
+            pts.reserve( n );
+            for( std::size_t i=0; i<n; ++i ) {
+                pts.emplace_back( group );
+                if( !good[i] || !pts.back( ) ||
+                    !BN_bin2bn( tweaks + i * 32, 32, t.get( ) ) ||
+                    1 != EC_POINT_mul( group, pts.back( ).get( ), t.get( ),
+                                       parent.get( ), one.get( ), ctx.get( ) ) )
+                {
+                    good[i] = false;
+                    continue;
+                }
+                raw[i] = pts.back( ).get( );
+            }
+            ec_point::serialize_many( group, raw.data( ), n, out, true,
+                                      ctx.get( ) );
+            for( std::size_t i=0; i<n; ++i ) {
+                if( good[i] && out[i * 33] == 0 ) {
+                    good[i] = false;
+                }
+            }
+            return true;
+#endif
+        }
+
+        static
+        void put_be32( std::uint8_t *p, std::uint32_t v )
+        {
+            p[0] = static_cast<std::uint8_t>(v >> 24);
+            p[1] = static_cast<std::uint8_t>(v >> 16);
+            p[2] = static_cast<std::uint8_t>(v >>  8);
+            p[3] = static_cast<std::uint8_t>(v      );
+        }
+
+        static
+        std::uint32_t get_be32( const std::uint8_t *p )
+        {
+            return ( static_cast<std::uint32_t>(p[0]) << 24 )
+                 | ( static_cast<std::uint32_t>(p[1]) << 16 )
+                 | ( static_cast<std::uint32_t>(p[2]) <<  8 )
+                 | ( static_cast<std::uint32_t>(p[3])       );
+        }
+    };
+
+}}
+
+#endif // BLOCK_CHAIN_BIP32_H
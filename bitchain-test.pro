@@ -5,9 +5,15 @@ CONFIG -= qt
 
 SOURCES += main.cpp \
     script.cpp \
-    test-script.cpp
+    test-script.cpp \
+    bench-hash.cpp
 
-LIBS += -lcrypto
+LIBS += -lcrypto -lpthread
+
+# in-tree secp256k1 arithmetic behind crypto::ec_key / crypto::signature;
+# its generator comb table is what makes key derivation batch well.
+# Comment out to fall back to plain OpenSSL EC_POINT_mul.
+DEFINES += BITCHAIN_NATIVE_SECP256K1
 
 HEADERS += \
     byte_order.h \
@@ -66,7 +72,18 @@ HEADERS += \
     parser.h \
     etool/include/etool/details/result.h \
     address.h \
-    tx.h
+    tx.h \
+    sha256_engine.h \
+    ripemd160_engine.h \
+    thread_pool.h \
+    merkle.h \
+    sighash.h \
+    signer.h \
+    secp256k1.h \
+    verify_cache.h \
+    vanity.h \
+    bip32.h \
+    watch_list.h
 
 INCLUDEPATH += etool/include
 
@@ -0,0 +1,18 @@
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= app_bundle
+CONFIG -= qt
+
+# catch-based known-answer tests; run the binary, it exits non-zero on
+# a failure
+SOURCES += test-main.cpp \
+    test-rfc6979.cpp \
+    test-sighash.cpp \
+    test-base58.cpp \
+    test-bip32.cpp
+
+LIBS += -lcrypto -lpthread
+
+DEFINES += BITCHAIN_NATIVE_SECP256K1
+
+INCLUDEPATH += etool/include
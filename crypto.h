@@ -7,17 +7,27 @@
 #include "openssl/ecdsa.h"
 #include "openssl/opensslv.h"
 #include "openssl/ssl.h"
+#include "openssl/rand.h"
 
 #include <memory>
 #include <random>
+#include <array>
+#include <vector>
+#include <atomic>
+#include <memory.h>
 
 #include "hash.h"
+#include "thread_pool.h"
 
 #include "etool/details/result.h"
 
+#if defined(BITCHAIN_NATIVE_SECP256K1)
+#   include "secp256k1.h"
+#endif
+
 namespace bchain { namespace crypto {
 
-#define BITCHAIN_CRYPTO_COMMON_IMPL( ThisType, ValueType  ) \
+#define BITCHAIN_CRYPTO_COMMON_MOVE( ThisType )              \
                                                             \
     ThisType( ThisType &o ) = delete;                       \
     ThisType &operator = ( ThisType &o ) = delete;          \
@@ -32,6 +42,13 @@ namespace bchain { namespace crypto {
         return *this;                                       \
     }                                                       \
                                                             \
+    void swap( ThisType &other )                            \
+    {                                                       \
+        std::swap( val_, other.val_ );                      \
+    }
+
+#define BITCHAIN_CRYPTO_COMMON_ACCESS( ValueType )          \
+                                                            \
     ValueType *get( )                                       \
     {                                                       \
         return val_;                                        \
@@ -49,11 +66,6 @@ namespace bchain { namespace crypto {
         return tmp;                                         \
     }                                                       \
                                                             \
-    void swap( ThisType &other )                            \
-    {                                                       \
-        std::swap( val_, other.val_ );                      \
-    }                                                       \
-                                                            \
     operator bool ( ) const                                 \
     {                                                       \
         return get( ) != nullptr;                           \
@@ -63,6 +75,192 @@ namespace bchain { namespace crypto {
                                                             \
         ValueType *val_ = nullptr
 
+#define BITCHAIN_CRYPTO_COMMON_IMPL( ThisType, ValueType  ) \
+    BITCHAIN_CRYPTO_COMMON_MOVE( ThisType )                 \
+    BITCHAIN_CRYPTO_COMMON_ACCESS( ValueType )
+
+    /// One secp256k1 group for the whole process, built on first use.
+    /// Keys made by new_key( ) hold a copy of it instead of looking the
+    /// curve up again.
+    struct curve {
+
+        static
+        const EC_GROUP *secp256k1( )
+        {
+            static const group_holder inst;
+            return inst.group;
+        }
+
+        static
+        EC_KEY *new_key( int curve_name = NID_secp256k1 )
+        {
+            if( curve_name != NID_secp256k1 || !secp256k1( ) ) {
+                return EC_KEY_new_by_curve_name( curve_name );
+            }
+            EC_KEY *k = EC_KEY_new( );
+            if( k && 1 != EC_KEY_set_group( k, secp256k1( ) ) ) {
+                EC_KEY_free( k );
+                k = nullptr;
+            }
+            return k;
+        }
+
+    private:
+
+        struct group_holder {
+
+            group_holder( )
+                :group(EC_GROUP_new_by_curve_name(NID_secp256k1))
+            { }
+
+            ~group_holder( )
+            {
+                if( group ) {
+                    EC_GROUP_free( group );
+                }
+            }
+
+            EC_GROUP *group;
+        };
+    };
+
+    /// Per-thread free lists of BN_CTX, BIGNUM and secp256k1 EC_POINT
+    /// objects. bn_ctx, bignum and ec_point take from here and give back
+    /// on destruction, so a hot path stops paying malloc/free for its
+    /// scratch objects. Bignums are cleared and points reset to infinity
+    /// before they are kept. Objects handed back after the thread's lists
+    /// are gone (static destructors) are just freed.
+    class scratch {
+
+    public:
+
+        /// objects of each kind kept per thread
+        enum { keep = 32 };
+
+        static
+        BN_CTX *take_ctx( )
+        {
+            auto *l = lists( );
+            if( l && !l->ctx.empty( ) ) {
+                BN_CTX *res = l->ctx.back( );
+                l->ctx.pop_back( );
+                return res;
+            }
+            return BN_CTX_new( );
+        }
+
+        static
+        void give( BN_CTX *ctx )
+        {
+            auto *l = lists( );
+            if( l && l->ctx.size( ) < keep ) {
+                l->ctx.push_back( ctx );
+            } else {
+                BN_CTX_free( ctx );
+            }
+        }
+
+        static
+        BIGNUM *take_bignum( )
+        {
+            auto *l = lists( );
+            if( l && !l->bn.empty( ) ) {
+                BIGNUM *res = l->bn.back( );
+                l->bn.pop_back( );
+                return res;
+            }
+            return BN_new( );
+        }
+
+        static
+        void give( BIGNUM *bn )
+        {
+            auto *l = lists( );
+            if( l && l->bn.size( ) < keep ) {
+                BN_clear( bn );
+                l->bn.push_back( bn );
+            } else {
+                BN_clear_free( bn );
+            }
+        }
+
+        /// Only secp256k1 points are pooled; they fit any group of that
+        /// curve.
+        static
+        bool pooled( const EC_GROUP *group )
+        {
+            return group && EC_GROUP_get_curve_name( group ) == NID_secp256k1;
+        }
+
+        static
+        EC_POINT *take_point( const EC_GROUP *group )
+        {
+            auto *l = lists( );
+            if( l && !l->pts.empty( ) && pooled( group ) ) {
+                EC_POINT *res = l->pts.back( );
+                l->pts.pop_back( );
+                return res;
+            }
+            return group ? EC_POINT_new( group ) : nullptr;
+        }
+
+        /// 'pt' must be a secp256k1 point
+        static
+        void give( EC_POINT *pt )
+        {
+            auto *l = lists( );
+            if( l && l->pts.size( ) < keep &&
+                1 == EC_POINT_set_to_infinity( curve::secp256k1( ), pt ) )
+            {
+                l->pts.push_back( pt );
+            } else {
+                EC_POINT_clear_free( pt );
+            }
+        }
+
+    private:
+
+        struct free_lists {
+
+            ~free_lists( )
+            {
+                dead( ) = true;
+                for( auto c: ctx ) {
+                    BN_CTX_free( c );
+                }
+                for( auto b: bn ) {
+                    BN_clear_free( b );
+                }
+                for( auto p: pts ) {
+                    EC_POINT_clear_free( p );
+                }
+            }
+
+            std::vector<BN_CTX *>   ctx;
+            std::vector<BIGNUM *>   bn;
+            std::vector<EC_POINT *> pts;
+        };
+
+        /// trivially destructible, so still readable after free_lists
+        /// of this thread is destroyed
+        static
+        bool &dead( )
+        {
+            static thread_local bool val = false;
+            return val;
+        }
+
+        static
+        free_lists *lists( )
+        {
+            if( dead( ) ) {
+                return nullptr;
+            }
+            static thread_local free_lists inst;
+            return dead( ) ? nullptr : &inst;
+        }
+    };
+
     class bn_ctx {
 
     public:
@@ -70,7 +268,7 @@ namespace bchain { namespace crypto {
         using this_type  = bn_ctx;
 
         bn_ctx( )
-            :val_(BN_CTX_new( ))
+            :val_(scratch::take_ctx( ))
         {
             if( val_ ) {
                 BN_CTX_start( val_ );
@@ -81,7 +279,7 @@ namespace bchain { namespace crypto {
         {
             if( val_ ) {
                 BN_CTX_end( val_ );
-                BN_CTX_free( val_ );
+                scratch::give( val_ );
             }
         }
 
@@ -96,13 +294,13 @@ namespace bchain { namespace crypto {
         using this_type  = bignum;
 
         bignum( )
-            :val_(BN_new( ))
+            :val_(scratch::take_bignum( ))
         { }
 
         ~bignum( )
         {
             if(val_) {
-                BN_free( val_ );
+                scratch::give( val_ );
             }
         }
 
@@ -140,19 +338,322 @@ namespace bchain { namespace crypto {
         { }
 
         ec_point( const EC_GROUP *group )
-            :val_(EC_POINT_new(group))
+            :pooled_(scratch::pooled(group))
+            ,val_(scratch::take_point(group))
         { }
 
         ~ec_point( )
         {
-            if( val_ ) {
+            reset( );
+        }
+
+        ec_point( ec_point &o ) = delete;
+        ec_point &operator = ( ec_point &o ) = delete;
+
+        /// The pooled flag travels with the point, so it still goes back
+        /// to scratch when the new owner dies.
+        ec_point( ec_point &&o )
+            :pooled_(o.pooled_)
+            ,val_(o.release( ))
+        { }
+
+        ec_point &operator = ( ec_point &&o )
+        {
+            if( this != &o ) {
+                reset( );
+                pooled_ = o.pooled_;
+                val_    = o.release( );
+            }
+            return *this;
+        }
+
+        void swap( ec_point &other )
+        {
+            std::swap( val_,    other.val_ );
+            std::swap( pooled_, other.pooled_ );
+        }
+
+        /// Gives the point back to scratch or frees it.
+        void reset( )
+        {
+            if( val_ && pooled_ ) {
+                scratch::give( val_ );
+            } else if( val_ ) {
                 EC_POINT_free( val_ );
             }
+            val_ = nullptr;
+        }
+
+        /// SEC1 length of a point on 'group'
+        static
+        std::size_t encoded_size( const EC_GROUP *group, bool compressed )
+        {
+            std::size_t field = ( EC_GROUP_get_degree( group ) + 7 ) / 8;
+            return compressed ? 1 + field : 1 + field * 2;
+        }
+
+        /// Writes 'count' points back to back into 'out' at
+        /// encoded_size( ) bytes each. All points are first made affine
+        /// together (EC_POINTs_make_affine, one field inversion for the
+        /// batch), so no per-point inversion is left for point2oct.
+        /// Points at infinity are written as zeroes and make the call
+        /// return false.
+        static
+        bool serialize_many( const EC_GROUP *group, EC_POINT *const *points,
+                             std::size_t count, std::uint8_t *out,
+                             bool compressed, BN_CTX *ctx = nullptr )
+        {
+            std::size_t len = encoded_size( group, compressed );
+            std::vector<EC_POINT *>  finite;
+            std::vector<std::size_t> slot;
+            bool res = true;
+
+            finite.reserve( count );
+            slot.reserve( count );
+            for( std::size_t i=0; i<count; ++i ) {
+                if( !points[i] || EC_POINT_is_at_infinity( group, points[i] ) ) {
+                    memset( out + i * len, 0, len );
+                    res = false;
+                } else {
+                    finite.push_back( points[i] );
+                    slot.push_back( i );
+                }
+            }
+
+            if( !finite.empty( ) &&
+                1 != EC_POINTs_make_affine( group, finite.size( ),
+                                            finite.data( ), ctx ) )
+            {
+                return false;
+            }
+
+            auto form = compressed ? POINT_CONVERSION_COMPRESSED
+                                   : POINT_CONVERSION_UNCOMPRESSED;
+            for( std::size_t i=0; i<finite.size( ); ++i ) {
+                if( EC_POINT_point2oct( group, finite[i], form,
+                                        out + slot[i] * len, len,
+                                        ctx ) != len )
+                {
+                    res = false;
+                }
+            }
+            return res;
         }
 
-        BITCHAIN_CRYPTO_COMMON_IMPL(ec_point, EC_POINT);
+    private:
+
+        /// set for points taken from scratch; a point that does not fit
+        /// the pool when given back is freed
+        bool pooled_ = false;
+
+    public:
+
+        BITCHAIN_CRYPTO_COMMON_ACCESS(EC_POINT);
     };
 
+#if defined(BITCHAIN_NATIVE_SECP256K1)
+
+    /// Moves keys and signatures between the OpenSSL objects and the
+    /// in-tree secp256k1 arithmetic (secp256k1.h). Only keys on secp256k1
+    /// are taken; anything else stays with OpenSSL.
+    struct native {
+
+        static
+        bool accepts( const EC_KEY *k )
+        {
+            const EC_GROUP *group = k ? EC_KEY_get0_group( k ) : nullptr;
+            return group && EC_GROUP_get_curve_name( group ) == NID_secp256k1;
+        }
+
+        /// false if 'bn' is missing or not below the group order
+        static
+        bool get_scalar( const BIGNUM *bn, secp256k1::scalar &s )
+        {
+            std::uint8_t buf[32];
+            if( !bn || BN_is_negative( bn ) || BN_num_bytes( bn ) > 32 ) {
+                return false;
+            }
+            BN_bn2binpad( bn, buf, sizeof(buf) );
+            return secp256k1::scalar::set_bytes( s, buf );
+        }
+
+        static
+        BIGNUM *make_bignum( const secp256k1::scalar &s )
+        {
+            std::uint8_t buf[32];
+            s.get_bytes( buf );
+            return BN_bin2bn( buf, sizeof(buf), nullptr );
+        }
+
+        static
+        bool get_public( const EC_KEY *k, secp256k1::ge &q )
+        {
+            const EC_POINT *pub = EC_KEY_get0_public_key( k );
+            std::uint8_t buf[65];
+            if( !pub || EC_POINT_point2oct( EC_KEY_get0_group( k ), pub,
+                                            POINT_CONVERSION_UNCOMPRESSED,
+                                            buf, sizeof(buf), nullptr )
+                        != sizeof(buf) )
+            {
+                return false;
+            }
+            return secp256k1::ge::parse( q, buf, sizeof(buf) );
+        }
+
+        static
+        bool make_public( const EC_GROUP *group, const BIGNUM *priv,
+                          EC_POINT *pub )
+        {
+            secp256k1::scalar d;
+            if( !get_scalar( priv, d ) || d.is_zero( ) ) {
+                return false;
+            }
+            std::uint8_t buf[65];
+            auto len = secp256k1::ecdsa::public_key( d ).serialize( buf, false );
+            return 1 == EC_POINT_oct2point( group, pub, buf, len, nullptr );
+        }
+
+        /// see ec_key::derive_public_many
+        static
+        bool derive_many( const std::uint8_t *privs, std::size_t count,
+                          std::uint8_t *out, bool compressed )
+        {
+            std::vector<secp256k1::gej> jac(count);
+            std::vector<secp256k1::ge>  aff(count);
+            bool res = true;
+
+            for( std::size_t i=0; i<count; ++i ) {
+                secp256k1::scalar d;
+                if( !secp256k1::scalar::set_bytes( d, privs + i * 32 )
+                    || d.is_zero( ) )
+                {
+                    jac[i] = secp256k1::gej::inf( );
+                    res = false;
+                } else {
+                    jac[i] = secp256k1::ecmult::gen( d );
+                }
+                OPENSSL_cleanse( &d, sizeof(d) );
+            }
+
+            secp256k1::points::to_affine( jac.data( ), count, aff.data( ) );
+
+            std::size_t len = compressed ? 33 : 65;
+            for( std::size_t i=0; i<count; ++i ) {
+                if( aff[i].infinity ) {
+                    memset( out + i * len, 0, len );
+                } else {
+                    aff[i].serialize( out + i * len, compressed );
+                }
+            }
+            return res;
+        }
+
+        /// random nonce, as ECDSA_do_sign does
+        static
+        ECDSA_SIG *sign( const std::uint8_t *dgst, std::size_t len,
+                         const EC_KEY *k )
+        {
+            return sign_with( dgst, len, k, false,
+                [ ]( std::uint8_t *buf ) {
+                    return 1 == RAND_bytes( buf, 32 );
+                } );
+        }
+
+        /// 'next_nonce( buf )' writes the next 32-byte candidate and
+        /// returns false if it has none; 'low_s' negates s above n / 2.
+        template <typename NonceF>
+        static
+        ECDSA_SIG *sign_with( const std::uint8_t *dgst, std::size_t len,
+                              const EC_KEY *k, bool low_s,
+                              NonceF next_nonce )
+        {
+            secp256k1::scalar d;
+            if( !get_scalar( EC_KEY_get0_private_key( k ), d ) ) {
+                return nullptr;
+            }
+            auto msg = secp256k1::ecdsa::digest_scalar( dgst, len );
+
+            secp256k1::scalar r, s, nonce;
+            std::uint8_t buf[32];
+            bool done = false;
+            while( !done ) {
+                if( !next_nonce( buf ) ) {
+                    break;
+                }
+                done = secp256k1::scalar::set_bytes( nonce, buf )
+                    && secp256k1::ecdsa::sign( r, s, d, msg, nonce );
+            }
+            OPENSSL_cleanse( buf, sizeof(buf) );
+            OPENSSL_cleanse( &nonce, sizeof(nonce) );
+            OPENSSL_cleanse( &d, sizeof(d) );
+            if( !done ) {
+                return nullptr;
+            }
+            if( low_s && s.is_high( ) ) {
+                s = secp256k1::scalar::negate( s );
+            }
+
+            ECDSA_SIG *sig = ECDSA_SIG_new( );
+            if( sig && 1 != ECDSA_SIG_set0( sig, make_bignum( r ),
+                                                 make_bignum( s ) ) )
+            {
+                ECDSA_SIG_free( sig );
+                sig = nullptr;
+            }
+            return sig;
+        }
+
+        /// same results as ECDSA_do_verify: 1, 0 or -1
+        static
+        int verify( const std::uint8_t *dgst, std::size_t len,
+                    const ECDSA_SIG *sig, const EC_KEY *k )
+        {
+            secp256k1::ge q;
+            if( !sig || !get_public( k, q ) ) {
+                return -1;
+            }
+            const BIGNUM *br = nullptr;
+            const BIGNUM *bs = nullptr;
+            ECDSA_SIG_get0( sig, &br, &bs );
+
+            secp256k1::scalar r, s;
+            if( !get_scalar( br, r ) || !get_scalar( bs, s ) ) {
+                return 0;
+            }
+            return verify( dgst, len, r, s, q );
+        }
+
+        /// r and s as 32-byte big-endian integers; no ECDSA_SIG needed
+        static
+        int verify( const std::uint8_t *dgst, std::size_t len,
+                    const std::uint8_t *rb, const std::uint8_t *sb,
+                    const EC_KEY *k )
+        {
+            secp256k1::ge q;
+            if( !get_public( k, q ) ) {
+                return -1;
+            }
+            secp256k1::scalar r, s;
+            if( !secp256k1::scalar::set_bytes( r, rb )
+             || !secp256k1::scalar::set_bytes( s, sb ) )
+            {
+                return 0;
+            }
+            return verify( dgst, len, r, s, q );
+        }
+
+        static
+        int verify( const std::uint8_t *dgst, std::size_t len,
+                    const secp256k1::scalar &r, const secp256k1::scalar &s,
+                    const secp256k1::ge &q )
+        {
+            auto msg = secp256k1::ecdsa::digest_scalar( dgst, len );
+            return secp256k1::ecdsa::verify( r, s, q, msg ) ? 1 : 0;
+        }
+    };
+
+#endif
+
     class ec_key {
 
     public:
@@ -183,7 +684,7 @@ namespace bchain { namespace crypto {
         ec_key generate( int curve_name )
         {
             ec_key res;
-            ec_key k(EC_KEY_new_by_curve_name(curve_name));
+            ec_key k(curve::new_key( curve_name ));
 
             if( k ) {
 
@@ -191,23 +692,8 @@ namespace bchain { namespace crypto {
                     return res;
                 }
 
-                const EC_GROUP *group = EC_KEY_get0_group(k.get( ));
-                const BIGNUM   *priv  = EC_KEY_get0_private_key(k.get( ));
-
-                ec_point pub(group);
-                bn_ctx   ctx;
-
-                if( !pub || !ctx || !group || !priv ) {
-                    return res;
-                }
-
-                if( 1 != EC_POINT_mul( group, pub.get( ), priv,
-                                       nullptr, nullptr,  ctx.get( ) ) )
-                {
-                    return res;
-                }
-
-                if( 1 != EC_KEY_set_public_key(k.get( ), pub.get( ) ) ) {
+                const BIGNUM *priv = EC_KEY_get0_private_key(k.get( ));
+                if( !set_public( k.get( ), priv ) ) {
                     return res;
                 }
 
@@ -263,6 +749,44 @@ namespace bchain { namespace crypto {
             return pub;
         }
 
+        /// Public keys of 'count' keys on one curve, back to back in 'out'
+        /// at ec_point::encoded_size( ) bytes each, through one BN_CTX.
+        /// EC_KEY keeps its public point affine, so unlike
+        /// ec_point::serialize_many there is no inversion to share.
+        static
+        bool get_public_bytes_many( const ec_key *keys, std::size_t count,
+                                    std::uint8_t *out, bool compressed )
+        {
+            if( count == 0 ) {
+                return true;
+            }
+            const EC_GROUP *group = EC_KEY_get0_group( keys[0].get( ) );
+            if( !group ) {
+                return false;
+            }
+
+            std::size_t len  = ec_point::encoded_size( group, compressed );
+            auto        form = compressed ? POINT_CONVERSION_COMPRESSED
+                                          : POINT_CONVERSION_UNCOMPRESSED;
+            bn_ctx ctx;
+            bool   res = true;
+
+            for( std::size_t i=0; i<count; ++i ) {
+                const EC_GROUP *g   = EC_KEY_get0_group( keys[i].get( ) );
+                const EC_POINT *pub = EC_KEY_get0_public_key( keys[i].get( ) );
+                std::uint8_t   *dst = out + i * len;
+                if( !g || !pub ||
+                    ec_point::encoded_size( g, compressed ) != len ||
+                    EC_POINT_point2oct( g, pub, form, dst, len,
+                                        ctx.get( ) ) != len )
+                {
+                    memset( dst, 0, len );
+                    res = false;
+                }
+            }
+            return res;
+        }
+
         std::string get_private_bytes( ) const
         {
             auto bn = EC_KEY_get0_private_key(get( ));
@@ -277,7 +801,7 @@ namespace bchain { namespace crypto {
         ec_key create_private( const U* priv_bytes, size_t lens )
         {
             ec_key res;
-            ec_key k(EC_KEY_new_by_curve_name(NID_secp256k1));
+            ec_key k(curve::new_key( ));
             size_t len = lens * sizeof(U);
 
             if( k ) {
@@ -293,21 +817,7 @@ namespace bchain { namespace crypto {
                     return res;
                 }
 
-                const EC_GROUP *group = EC_KEY_get0_group(k.get( ));
-                ec_point pub(group);
-                bn_ctx   ctx;
-
-                if( !pub || !ctx || !group ) {
-                    return res;
-                }
-
-                if( 1 != EC_POINT_mul( group, pub.get( ), priv.get( ),
-                                       nullptr, nullptr,  ctx.get( ) ) )
-                {
-                    return res;
-                }
-
-                if( 1 != EC_KEY_set_public_key(k.get( ), pub.get( ) ) ) {
+                if( !set_public( k.get( ), priv.get( ) ) ) {
                     return res;
                 }
 
@@ -321,7 +831,7 @@ namespace bchain { namespace crypto {
         ec_key create_public( const U* pub_bytes, size_t lens )
         {
             ec_key res;
-            ec_key k(EC_KEY_new_by_curve_name(NID_secp256k1));
+            ec_key k(curve::new_key( ));
             size_t len = lens * sizeof(U);
 
             if( k ) {
@@ -334,9 +844,454 @@ namespace bchain { namespace crypto {
             return res;
         }
 
+        /// items handed to a single worker by derive_public_many
+        enum { derive_grain = 256 };
+
+        static
+        std::size_t public_size( bool compressed )
+        {
+            return compressed ? 33 : 65;
+        }
+
+        /// Public keys of 'count' 32-byte big endian secp256k1 private
+        /// keys, written back to back into 'out' at public_size( ) bytes
+        /// each. Every chunk shares one group, one BN_CTX and one affine
+        /// conversion. Returns false if a private key is zero or not below
+        /// the group order; its slot is zeroed.
+        static
+        bool derive_public_many( const std::uint8_t *privs, std::size_t count,
+                                 std::uint8_t *out, bool compressed,
+                                 thread_pool *pool = nullptr )
+        {
+            std::atomic<bool> ok(true);
+            thread_pool &tp = pool ? *pool : thread_pool::common( );
+            std::size_t len = public_size( compressed );
+
+            tp.parallel_for( count, derive_grain,
+                [&]( std::size_t b, std::size_t e ) {
+                    if( !derive_range( privs + b * 32, e - b, out + b * len,
+                                       compressed ) )
+                    {
+                        ok = false;
+                    }
+                } );
+            return ok;
+        }
+
+    private:
+
+        static
+        bool derive_range( const std::uint8_t *privs, std::size_t count,
+                           std::uint8_t *out, bool compressed )
+        {
+#if defined(BITCHAIN_NATIVE_SECP256K1)
+            return native::derive_many( privs, count, out, compressed );
+#else
+            const EC_GROUP *group = curve::secp256k1( );
+            bn_ctx          ctx;
+            bignum          priv;
+            bool            res = true;
+
+            if( !group || !ctx || !priv ) {
+                return false;
+            }
+
+            std::vector<ec_point>  pts;
+            std::vector<EC_POINT *> raw(count, nullptr);
+            pts.reserve( count );
+
+            for( std::size_t i=0; i<count; ++i ) {
+                BN_bin2bn( privs + i * 32, 32, priv.get( ) );
+                pts.emplace_back( group );
+                if( BN_is_zero( priv.get( ) ) ||
+                    BN_cmp( priv.get( ), EC_GROUP_get0_order( group ) ) >= 0 ||
+                    1 != EC_POINT_mul( group, pts.back( ).get( ), priv.get( ),
+                                       nullptr, nullptr, ctx.get( ) ) )
+                {
+                    res = false;
+                    continue;
+                }
+                raw[i] = pts.back( ).get( );
+            }
+            BN_clear( priv.get( ) );
+
+            return ec_point::serialize_many( group, raw.data( ), count, out,
+                                             compressed, ctx.get( ) ) && res;
+#endif
+        }
+
+        /// Derives the public point of 'priv' and stores it in 'k'.
+        static
+        bool set_public( EC_KEY *k, const BIGNUM *priv )
+        {
+            const EC_GROUP *group = EC_KEY_get0_group(k);
+            ec_point pub(group);
+            bn_ctx   ctx;
+
+            if( !pub || !ctx || !group || !priv ) {
+                return false;
+            }
+
+#if defined(BITCHAIN_NATIVE_SECP256K1)
+            bool done = native::accepts( k )
+                     && native::make_public( group, priv, pub.get( ) );
+#else
+            bool done = false;
+#endif
+            if( !done && 1 != EC_POINT_mul( group, pub.get( ), priv,
+                                            nullptr, nullptr, ctx.get( ) ) )
+            {
+                return false;
+            }
+
+            return 1 == EC_KEY_set_public_key( k, pub.get( ) );
+        }
+
+    public:
+
         BITCHAIN_CRYPTO_COMMON_IMPL(ec_key, EC_KEY);
     };
 
+    /// RFC 6979 nonces for secp256k1 keys, HMAC-SHA256 flavour.
+    ///
+    /// The first HMAC of step d runs under the all-zero K over
+    /// V || 0x00 || x || h1; everything but the last key byte and h1 is
+    /// fixed per key, so that midstate is computed once here. A nonce then
+    /// costs the remaining HMACs of steps d..h, about twenty compressions,
+    /// and never touches the OpenSSL RNG.
+    class rfc6979 {
+
+    public:
+
+        enum { length = 32 };
+
+        /// valid( ) is false unless 'k' holds a private key on secp256k1
+        explicit rfc6979( const EC_KEY *k )
+        {
+            const BIGNUM *priv = k ? EC_KEY_get0_private_key( k ) : nullptr;
+            if( !priv || BN_is_negative( priv ) || BN_num_bytes( priv ) > length
+                || EC_GROUP_get_curve_name( EC_KEY_get0_group( k ) )
+                                                        != NID_secp256k1 )
+            {
+                return;
+            }
+            BN_bn2binpad( priv, x_, length );
+            valid_ = !BN_is_zero( priv ) && below_order( x_ );
+
+            std::uint8_t v[length + 1];
+            memset( v, 0x01, length );
+            v[length] = 0x00;
+            first_ = zero_key( ).begin( );
+            first_.update( v, sizeof(v) );
+            first_.update( x_, length - 1 );
+        }
+
+        ~rfc6979( )
+        {
+            OPENSSL_cleanse( x_, sizeof(x_) );
+            OPENSSL_cleanse( &first_, sizeof(first_) );
+        }
+
+        bool valid( ) const
+        {
+            return valid_;
+        }
+
+        /// Nonce candidates for one digest, in RFC order. The caller asks
+        /// for another one if a candidate gives r == 0 or s == 0.
+        class generator {
+
+        public:
+
+            generator( const rfc6979 &key, const std::uint8_t *dgst,
+                       std::size_t len )
+            {
+                std::uint8_t h1[length];
+                bits2octets( dgst, len, h1 );
+
+                std::uint8_t k[length];
+                auto ctx = key.first_;
+                ctx.update( key.x_ + length - 1, 1 );
+                ctx.update( h1, length );
+                zero_key( ).final( ctx, k );
+
+                memset( v_, 0x01, length );
+                mac_.set_key( k, length );
+                mac_.get( v_, v_, length );
+
+                const std::uint8_t one = 0x01;
+                ctx = mac_.begin( );
+                ctx.update( v_, length );
+                ctx.update( &one, 1 );
+                ctx.update( key.x_, length );
+                ctx.update( h1, length );
+                mac_.final( ctx, k );
+
+                mac_.set_key( k, length );
+                mac_.get( v_, v_, length );
+                OPENSSL_cleanse( k, sizeof(k) );
+            }
+
+            ~generator( )
+            {
+                OPENSSL_cleanse( v_, sizeof(v_) );
+            }
+
+            /// writes the next nonce in [1, n - 1]
+            void next( std::uint8_t *out )
+            {
+                if( started_ ) {
+                    reseed( );
+                }
+                started_ = true;
+                while( true ) {
+                    mac_.get( v_, v_, length );
+                    if( !is_zero( v_ ) && below_order( v_ ) ) {
+                        memcpy( out, v_, length );
+                        return;
+                    }
+                    reseed( );
+                }
+            }
+
+        private:
+
+            /// K = HMAC_K(V || 0x00), V = HMAC_K(V)
+            void reseed( )
+            {
+                const std::uint8_t zero = 0x00;
+                std::uint8_t k[length];
+                auto ctx = mac_.begin( );
+                ctx.update( v_, length );
+                ctx.update( &zero, 1 );
+                mac_.final( ctx, k );
+                mac_.set_key( k, length );
+                mac_.get( v_, v_, length );
+                OPENSSL_cleanse( k, sizeof(k) );
+            }
+
+            hash::hmac_sha256   mac_;
+            std::uint8_t        v_[length];
+            bool                started_ = false;
+        };
+
+    private:
+
+        static
+        const hash::hmac_sha256 &zero_key( )
+        {
+            static const std::uint8_t k[length] = { 0 };
+            static const hash::hmac_sha256 mac(k, length);
+            return mac;
+        }
+
+        static
+        bool is_zero( const std::uint8_t *b )
+        {
+            std::uint8_t acc = 0;
+            for( int i=0; i<length; ++i ) {
+                acc |= b[i];
+            }
+            return acc == 0;
+        }
+
+        /// big-endian 'b' < n, without branching on the bytes
+        static
+        bool below_order( const std::uint8_t *b )
+        {
+            static const std::uint8_t n[length] = {
+                0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE,
+                0xBA, 0xAE, 0xDC, 0xE6, 0xAF, 0x48, 0xA0, 0x3B,
+                0xBF, 0xD2, 0x5E, 0x8C, 0xD0, 0x36, 0x41, 0x41,
+            };
+            int borrow = 0;
+            for( int i=length-1; i>=0; --i ) {
+                borrow = ( ( static_cast<int>(b[i]) - n[i] - borrow ) >> 8 ) & 1;
+            }
+            return borrow != 0;
+        }
+
+        /// bits2octets: the leftmost 256 bits of the digest taken as an
+        /// integer (shorter digests are right-aligned, like OpenSSL does),
+        /// then reduced mod n; one subtraction is enough.
+        static
+        void bits2octets( const std::uint8_t *dgst, std::size_t len,
+                          std::uint8_t *out )
+        {
+            memset( out, 0, length );
+            if( len > length ) {
+                len = length;
+            }
+            memcpy( out + length - len, dgst, len );
+            if( !below_order( out ) ) {
+                static const std::uint8_t n_neg[length] = {
+                    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+                    0x45, 0x51, 0x23, 0x19, 0x50, 0xB7, 0x5F, 0xC4,
+                    0x40, 0x2D, 0xA1, 0x73, 0x2F, 0xC9, 0xBE, 0xBF,
+                };
+                int carry = 0;
+                for( int i=length-1; i>=0; --i ) {
+                    int sum = out[i] + n_neg[i] + carry;
+                    out[i] = static_cast<std::uint8_t>(sum);
+                    carry = sum >> 8;
+                }
+            }
+        }
+
+        std::uint8_t            x_[length];
+        hash::sha256::context   first_;
+        bool                    valid_ = false;
+    };
+
+    /// ECDSA signature with r and s as big-endian 32-byte arrays, small
+    /// enough to live on the stack. DER is parsed and written directly
+    /// between caller buffers and these arrays; an ECDSA_SIG is only
+    /// built when OpenSSL has to see the signature.
+    struct compact_signature {
+
+        enum { scalar_length  = 32 };
+
+        /// 0x30 L 0x02 33 (0x00 r) 0x02 33 (0x00 s)
+        enum { max_der_length = 6 + 2 * ( scalar_length + 1 ) };
+
+        using scalar_type = std::array<std::uint8_t, scalar_length>;
+
+        scalar_type r;
+        scalar_type s;
+
+        /// Strict DER, the BIP66 rules: one SEQUENCE of two positive
+        /// INTEGERs, minimal lengths, no padding zero unless the next byte
+        /// has its top bit set, nothing after it. Values wider than 32
+        /// bytes are refused. 'out' is only written on success.
+        static
+        bool from_der( compact_signature &out, const std::uint8_t *der,
+                       std::size_t len )
+        {
+            if( len < 8 || len > max_der_length
+             || der[0] != 0x30 || der[1] != len - 2 )
+            {
+                return false;
+            }
+
+            std::size_t len_r = der[3];
+            if( der[2] != 0x02 || 5 + len_r >= len ) {
+                return false;
+            }
+            std::size_t len_s = der[5 + len_r];
+            if( der[4 + len_r] != 0x02 || 6 + len_r + len_s != len ) {
+                return false;
+            }
+
+            compact_signature res;
+            if( !read_integer( der + 4, len_r, res.r.data( ) )
+             || !read_integer( der + 6 + len_r, len_s, res.s.data( ) ) )
+            {
+                return false;
+            }
+            out = res;
+            return true;
+        }
+
+        template <typename U>
+        static
+        bool from_der( compact_signature &out, const U *der, std::size_t len )
+        {
+            return from_der( out, reinterpret_cast<const std::uint8_t *>(der),
+                             len * sizeof(U) );
+        }
+
+        /// Writes DER into 'out' (max_der_length bytes at least) and
+        /// returns its length.
+        std::size_t to_der( std::uint8_t *out ) const
+        {
+            std::size_t pos = 2;
+            pos += write_integer( r.data( ), out + pos );
+            pos += write_integer( s.data( ), out + pos );
+            out[0] = 0x30;
+            out[1] = static_cast<std::uint8_t>(pos - 2);
+            return pos;
+        }
+
+        std::string to_der( ) const
+        {
+            std::uint8_t buf[max_der_length];
+            auto len = to_der( buf );
+            return std::string( reinterpret_cast<const char *>(buf), len );
+        }
+
+        /// false if r or s do not fit 32 bytes
+        static
+        bool from_sig( compact_signature &out, const ECDSA_SIG *sig )
+        {
+            const BIGNUM *br = nullptr;
+            const BIGNUM *bs = nullptr;
+            if( !sig ) {
+                return false;
+            }
+            ECDSA_SIG_get0( sig, &br, &bs );
+            return 0 < BN_bn2binpad( br, out.r.data( ), scalar_length )
+                && 0 < BN_bn2binpad( bs, out.s.data( ), scalar_length );
+        }
+
+        /// new ECDSA_SIG owned by the caller; nullptr on failure
+        ECDSA_SIG *to_sig( ) const
+        {
+            ECDSA_SIG *sig = ECDSA_SIG_new( );
+            BIGNUM *br = BN_bin2bn( r.data( ), scalar_length, nullptr );
+            BIGNUM *bs = BN_bin2bn( s.data( ), scalar_length, nullptr );
+            if( !sig || !br || !bs || 1 != ECDSA_SIG_set0( sig, br, bs ) ) {
+                BN_free( br );
+                BN_free( bs );
+                ECDSA_SIG_free( sig );
+                return nullptr;
+            }
+            return sig;
+        }
+
+    private:
+
+        static
+        bool read_integer( const std::uint8_t *src, std::size_t len,
+                           std::uint8_t *dst )
+        {
+            if( len == 0 || ( src[0] & 0x80 ) ) {
+                return false;
+            }
+            if( len > 1 && src[0] == 0x00 && !( src[1] & 0x80 ) ) {
+                return false;
+            }
+            if( src[0] == 0x00 && len > 1 ) {
+                ++src;
+                --len;
+            }
+            if( len > scalar_length ) {
+                return false;
+            }
+            memset( dst, 0, scalar_length - len );
+            memcpy( dst + scalar_length - len, src, len );
+            return true;
+        }
+
+        static
+        std::size_t write_integer( const std::uint8_t *src, std::uint8_t *dst )
+        {
+            std::size_t skip = 0;
+            while( skip < scalar_length - 1 && src[skip] == 0 ) {
+                ++skip;
+            }
+            std::size_t len = scalar_length - skip;
+            std::size_t pad = ( src[skip] & 0x80 ) ? 1 : 0;
+
+            dst[0] = 0x02;
+            dst[1] = static_cast<std::uint8_t>(len + pad);
+            dst[2] = 0x00;
+            memcpy( dst + 2 + pad, src + skip, len );
+            return 2 + pad + len;
+        }
+    };
+
     class signature {
     public:
 
@@ -369,7 +1324,7 @@ namespace bchain { namespace crypto {
         signature sign( const U  *digest, size_t len, EC_KEY *k )
         {
             auto data = reinterpret_cast<const std::uint8_t *>(digest);
-            signature s( ECDSA_do_sign(data, len * sizeof(U), k) );
+            signature s( do_sign(data, len * sizeof(U), k) );
 
             return s;
         }
@@ -383,11 +1338,43 @@ namespace bchain { namespace crypto {
             return sign( &digest[0], HashT::digest_length, k );
         }
 
+        /// Deterministic signature (RFC 6979) with s normalised to the
+        /// lower half; 'nonces' must be built from 'k'. Empty if it is
+        /// not valid or signing failed.
+        template <typename U>
+        static
+        signature sign_rfc6979( const U  *digest, size_t len,
+                                const rfc6979 &nonces, EC_KEY *k )
+        {
+            auto data = reinterpret_cast<const std::uint8_t *>(digest);
+            return signature( nonces.valid( )
+                            ? do_sign_rfc6979( data, len * sizeof(U), nonces, k )
+                            : nullptr );
+        }
+
+        /// Same with the per-key state built for this call only.
+        template <typename U>
+        static
+        signature sign_rfc6979( const U  *digest, size_t len, EC_KEY *k )
+        {
+            return sign_rfc6979( digest, len, rfc6979(k), k );
+        }
+
+        /// sign_rfc6979 straight to DER; empty on failure
+        template <typename U>
+        static
+        std::string sign_rfc6979_der( const U  *digest, size_t len,
+                                      const rfc6979 &nonces, EC_KEY *k )
+        {
+            auto s = sign_rfc6979( digest, len, nonces, k );
+            return s ? s.to_der( k ) : std::string( );
+        }
+
         template <typename U>
         int verify( const U  *mess, size_t len, EC_KEY *k )
         {
             auto data = reinterpret_cast<const unsigned char *>(mess);
-            return ECDSA_do_verify( data, len * sizeof(U), val_, k );
+            return do_verify( data, len * sizeof(U), val_, k );
         }
 
         template <typename U, typename HashT = hash::sha256>
@@ -395,7 +1382,7 @@ namespace bchain { namespace crypto {
         {
             typename HashT::digest_block digest;
             HashT::get( digest, mess, len * sizeof(U));
-            return ECDSA_do_verify( &digest[0], HashT::digest_length, val_, k );
+            return do_verify( &digest[0], HashT::digest_length, val_, k );
         }
 
         template <typename U>
@@ -403,7 +1390,7 @@ namespace bchain { namespace crypto {
         int verify( const U  *mess, size_t len, ECDSA_SIG *sig, EC_KEY *k )
         {
             auto data = reinterpret_cast<const unsigned char *>(mess);
-            return ECDSA_do_verify( data, len * sizeof(U), sig, k );
+            return do_verify( data, len * sizeof(U), sig, k );
         }
 
         template <typename U, typename HashT = hash::sha256>
@@ -413,11 +1400,85 @@ namespace bchain { namespace crypto {
         {
             typename HashT::digest_block digest;
             HashT::get( digest, mess, len * sizeof(U));
-            return ECDSA_do_verify( &digest[0], HashT::digest_length, sig, k );
+            return do_verify( &digest[0], HashT::digest_length, sig, k );
+        }
+
+        /// One (digest, signature, public key) triple for verify_batch.
+        struct batch_item {
+            const std::uint8_t *digest;
+            std::size_t         len;
+            const ECDSA_SIG    *sig;
+            EC_KEY             *key;
+        };
+
+        /// items handed to a single worker
+        enum { batch_grain = 16 };
+
+        /// Verifies all items; res[i] is what ECDSA_do_verify returned for
+        /// items[i] (1 valid, 0 invalid, -1 error).
+        static
+        std::vector<int> verify_batch( const batch_item *items,
+                                       std::size_t count,
+                                       thread_pool *pool = nullptr )
+        {
+            std::vector<int> res(count);
+            batch_pool( pool ).parallel_for( count, batch_grain,
+                [items, &res]( std::size_t b, std::size_t e ) {
+                    for( std::size_t i=b; i<e; ++i ) {
+                        res[i] = verify_item( items[i] );
+                    }
+                } );
+            return res;
+        }
+
+        /// Index of the first item that is not valid, or 'count'. Items
+        /// after a known failure are skipped.
+        static
+        std::size_t verify_batch_first( const batch_item *items,
+                                        std::size_t count,
+                                        thread_pool *pool = nullptr )
+        {
+            std::atomic<std::size_t> first(count);
+            batch_pool( pool ).parallel_for( count, batch_grain,
+                [items, &first]( std::size_t b, std::size_t e ) {
+                    for( std::size_t i=b; i<e && i<first; ++i ) {
+                        if( verify_item( items[i] ) != 1 ) {
+                            std::size_t cur = first;
+                            while( i < cur &&
+                                   !first.compare_exchange_weak( cur, i ) )
+                            { }
+                            return;
+                        }
+                    }
+                } );
+            return first;
+        }
+
+        /// true if every item is valid; all workers stop at the first
+        /// failure any of them sees.
+        static
+        bool verify_batch_all( const batch_item *items, std::size_t count,
+                               thread_pool *pool = nullptr )
+        {
+            std::atomic<bool> failed(false);
+            batch_pool( pool ).parallel_for( count, batch_grain,
+                [items, &failed]( std::size_t b, std::size_t e ) {
+                    for( std::size_t i=b; i<e && !failed; ++i ) {
+                        if( verify_item( items[i] ) != 1 ) {
+                            failed = true;
+                        }
+                    }
+                } );
+            return !failed;
         }
 
         std::string to_der( const EC_KEY *k ) const
         {
+            compact_signature c;
+            if( compact_signature::from_sig( c, get( ) ) ) {
+                return c.to_der( );
+            }
+
             auto t1 = ECDSA_size( k );
             std::string der( static_cast<size_t>(t1), '\0');
             auto der_copy = reinterpret_cast<std::uint8_t *>(&der[0]);
@@ -428,6 +1489,36 @@ namespace bchain { namespace crypto {
             return der;
         }
 
+        /// false for curves wider than 256 bits
+        bool to_compact( compact_signature &out ) const
+        {
+            return compact_signature::from_sig( out, get( ) );
+        }
+
+        static
+        signature from_compact( const compact_signature &c )
+        {
+            return signature( c.to_sig( ) );
+        }
+
+        /// Verifies a compact signature; the native backend reads r and s
+        /// as they are, OpenSSL gets a temporary ECDSA_SIG.
+        template <typename U>
+        static
+        int verify( const U  *mess, size_t len, const compact_signature &sig,
+                    EC_KEY *k )
+        {
+            auto data = reinterpret_cast<const unsigned char *>(mess);
+#if defined(BITCHAIN_NATIVE_SECP256K1)
+            if( native::accepts( k ) ) {
+                return native::verify( data, len * sizeof(U), sig.r.data( ),
+                                       sig.s.data( ), k );
+            }
+#endif
+            signature tmp(sig.to_sig( ));
+            return tmp ? do_verify( data, len * sizeof(U), tmp.get( ), k ) : -1;
+        }
+
         static
         signature from_der( const std::string &der )
         {
@@ -436,12 +1527,141 @@ namespace bchain { namespace crypto {
                                              static_cast<int>(der.size( ) ) ) );
         }
 
+    private:
+
+        static
+        int verify_item( const batch_item &it )
+        {
+            return do_verify( it.digest, it.len, it.sig, it.key );
+        }
+
+        static
+        ECDSA_SIG *do_sign( const std::uint8_t *dgst, std::size_t len,
+                            EC_KEY *k )
+        {
+#if defined(BITCHAIN_NATIVE_SECP256K1)
+            if( native::accepts( k ) ) {
+                return native::sign( dgst, len, k );
+            }
+#endif
+            return ECDSA_do_sign( dgst, static_cast<int>(len), k );
+        }
+
+        /// OpenSSL path: k^-1 and r are computed here from the RFC 6979
+        /// nonce and handed to ECDSA_do_sign_ex, which then takes no
+        /// randomness of its own.
+        static
+        ECDSA_SIG *do_sign_rfc6979( const std::uint8_t *dgst, std::size_t len,
+                                    const rfc6979 &nonces, EC_KEY *k )
+        {
+            rfc6979::generator gen(nonces, dgst, len);
+#if defined(BITCHAIN_NATIVE_SECP256K1)
+            if( native::accepts( k ) ) {
+                return native::sign_with( dgst, len, k, true,
+                    [&gen]( std::uint8_t *buf ) {
+                        gen.next( buf );
+                        return true;
+                    } );
+            }
+#endif
+            /// r == 0 or s == 0 happen with probability ~2^-256; a few
+            /// failures in a row mean a real error, not a bad nonce
+            enum { max_tries = 4 };
+
+            const EC_GROUP *group = EC_KEY_get0_group( k );
+            const BIGNUM   *order = EC_GROUP_get0_order( group );
+            bn_ctx   ctx;
+            bignum   nonce;
+            bignum   kinv;
+            bignum   r;
+            ec_point R(group);
+            if( !ctx || !nonce || !kinv || !r || !R ) {
+                return nullptr;
+            }
+            BN_set_flags( nonce.get( ), BN_FLG_CONSTTIME );
+
+            ECDSA_SIG *sig = nullptr;
+            std::uint8_t buf[rfc6979::length];
+            for( int i=0; i<max_tries && !sig; ++i ) {
+                gen.next( buf );
+                if( !BN_bin2bn( buf, sizeof(buf), nonce.get( ) )
+                 || 1 != EC_POINT_mul( group, R.get( ), nonce.get( ),
+                                       nullptr, nullptr, ctx.get( ) )
+                 || 1 != EC_POINT_get_affine_coordinates( group, R.get( ),
+                                        r.get( ), nullptr, ctx.get( ) )
+                 || 1 != BN_nnmod( r.get( ), r.get( ), order, ctx.get( ) )
+                 || BN_is_zero( r.get( ) )
+                 || !BN_mod_inverse( kinv.get( ), nonce.get( ), order,
+                                     ctx.get( ) ) )
+                {
+                    continue;
+                }
+                sig = ECDSA_do_sign_ex( dgst, static_cast<int>(len),
+                                        kinv.get( ), r.get( ), k );
+            }
+            OPENSSL_cleanse( buf, sizeof(buf) );
+
+            if( sig && !normalize_s( sig, order ) ) {
+                ECDSA_SIG_free( sig );
+                sig = nullptr;
+            }
+            return sig;
+        }
+
+        /// s = n - s if s > n / 2
+        static
+        bool normalize_s( ECDSA_SIG *sig, const BIGNUM *order )
+        {
+            const BIGNUM *r = nullptr;
+            const BIGNUM *s = nullptr;
+            ECDSA_SIG_get0( sig, &r, &s );
+
+            bignum half;
+            if( !half || 1 != BN_rshift1( half.get( ), order ) ) {
+                return false;
+            }
+            if( BN_cmp( s, half.get( ) ) <= 0 ) {
+                return true;
+            }
+
+            BIGNUM *nr = BN_dup( r );
+            BIGNUM *ns = BN_new( );
+            if( !nr || !ns || 1 != BN_sub( ns, order, s )
+             || 1 != ECDSA_SIG_set0( sig, nr, ns ) )
+            {
+                BN_free( nr );
+                BN_free( ns );
+                return false;
+            }
+            return true;
+        }
+
+        static
+        int do_verify( const std::uint8_t *dgst, std::size_t len,
+                       const ECDSA_SIG *sig, EC_KEY *k )
+        {
+#if defined(BITCHAIN_NATIVE_SECP256K1)
+            if( native::accepts( k ) ) {
+                return native::verify( dgst, len, sig, k );
+            }
+#endif
+            return ECDSA_do_verify( dgst, static_cast<int>(len), sig, k );
+        }
+
+        static
+        thread_pool &batch_pool( thread_pool *pool )
+        {
+            return pool ? *pool : thread_pool::common( );
+        }
+
     public:
 
         BITCHAIN_CRYPTO_COMMON_IMPL(signature, ECDSA_SIG);
     };
 
 #undef BITCHAIN_CRYPTO_COMMON_IMPL
+#undef BITCHAIN_CRYPTO_COMMON_ACCESS
+#undef BITCHAIN_CRYPTO_COMMON_MOVE
 
 }}
 
@@ -3,10 +3,16 @@
 
 #include <cstdint>
 #include <memory>
+#include <string>
+#include <array>
 #include <memory.h>
 
 #include "openssl/sha.h"
 #include "openssl/ripemd.h"
+#include "openssl/crypto.h"
+
+#include "sha256_engine.h"
+#include "ripemd160_engine.h"
 
 namespace bchain { namespace hash {
 
@@ -16,6 +22,7 @@ namespace bchain { namespace hash {
         enum { digest_length = DigitLen };
         using parent_type = ParentHash;
         using digest_block = std::uint8_t[digest_length];
+        using slice = etool::slices::memory<const std::uint8_t>;
 
         template <typename U>
         static
@@ -46,6 +53,24 @@ namespace bchain { namespace hash {
             get( tmp, data, len );
             return (memcmp( dst, tmp, digest_length ) == 0);
         }
+
+        /// Generic batch form; hashes with a batched kernel override it.
+        static
+        void get_many( const slice *src, digest_block *dst, size_t count )
+        {
+            for( size_t i=0; i<count; ++i ) {
+                parent_type::get( dst[i], src[i].get( ), src[i].size( ) );
+            }
+        }
+
+        static
+        void append_many( const slice *src, size_t count, std::string &out )
+        {
+            auto s = out.size( );
+            out.resize( s + count * digest_length );
+            auto dst = reinterpret_cast<digest_block *>(&out[s]);
+            parent_type::get_many( src, dst, count );
+        }
     protected:
         common( ) = default;
     };
@@ -67,6 +92,40 @@ namespace bchain { namespace hash {
             SHA256_Final( dst, &ctx );
         }
 
+        /// Streaming form: init on construction, update any number of
+        /// times, final once. Copyable, so a shared prefix can be hashed
+        /// once and the copy carried on (midstate).
+        class context {
+
+        public:
+
+            context( )
+            {
+                SHA256_Init( &ctx_ );
+            }
+
+            template <typename U>
+            void update( const U *dat, size_t len )
+            {
+                SHA256_Update( &ctx_, dat, len * sizeof(U) );
+            }
+
+            void final( digest_block dst )
+            {
+                SHA256_Final( dst, &ctx_ );
+            }
+
+        private:
+            SHA256_CTX ctx_;
+        };
+
+        /// Hashes 'count' independent messages through the multi-buffer
+        /// engine (SHA-NI, AVX-512 or AVX2, picked at runtime).
+        static
+        void get_many( const slice *src, digest_block *dst, size_t count )
+        {
+            sha256_engine::hash_many( src, &dst[0][0], count );
+        }
     };
 
     struct ripemd160: public common<ripemd160, RIPEMD160_DIGEST_LENGTH> {
@@ -87,6 +146,47 @@ namespace bchain { namespace hash {
         }
     };
 
+    struct sha512: public common<sha512, SHA512_DIGEST_LENGTH> {
+
+        enum { digest_length = SHA512_DIGEST_LENGTH };
+        using digest_block = std::uint8_t[digest_length];
+
+        template <typename U>
+        static
+        void get( digest_block dst, const U *dat, size_t len )
+        {
+            SHA512_CTX ctx;
+            SHA512_Init(&ctx);
+            SHA512_Update( &ctx, dat, len * sizeof(U) );
+            SHA512_Final( dst, &ctx );
+        }
+
+        /// see sha256::context
+        class context {
+
+        public:
+
+            context( )
+            {
+                SHA512_Init( &ctx_ );
+            }
+
+            template <typename U>
+            void update( const U *dat, size_t len )
+            {
+                SHA512_Update( &ctx_, dat, len * sizeof(U) );
+            }
+
+            void final( digest_block dst )
+            {
+                SHA512_Final( dst, &ctx_ );
+            }
+
+        private:
+            SHA512_CTX ctx_;
+        };
+    };
+
     struct hash256: public common<hash256, sha256::digest_length> {
 
         enum { digest_length = sha256::digest_length };
@@ -96,8 +196,82 @@ namespace bchain { namespace hash {
         static
         void get( digest_block dst, const U *dat, size_t len )
         {
+            auto data = reinterpret_cast<const std::uint8_t *>(dat);
+            switch( len * sizeof(U) ) {
+            case 32:
+                return sha256d_fixed<32>::get( data, dst );
+            case 64:
+                return sha256d_fixed<64>::get( data, dst );
+            case 80:
+                return sha256d_fixed<80>::get( data, dst );
+            default:
+                break;
+            }
             sha256::get( dst, dat, len );
-            sha256::get( dst, dst, digest_length );
+            sha256_engine::sha256_32( dst, dst );
+        }
+
+        class context {
+
+        public:
+
+            template <typename U>
+            void update( const U *dat, size_t len )
+            {
+                first_.update( dat, len );
+            }
+
+            void final( digest_block dst )
+            {
+                first_.final( dst );
+                sha256_engine::sha256_32( dst, dst );
+            }
+
+        private:
+            sha256::context first_;
+        };
+
+        /// Length known at compile time: goes straight to the fixed-size
+        /// kernel without the runtime switch above.
+        template <size_t Len, typename U>
+        static
+        void get_fixed( digest_block dst, const U *dat )
+        {
+            auto data = reinterpret_cast<const std::uint8_t *>(dat);
+            sha256d_fixed<Len>::get( data, dst );
+        }
+
+        template <typename U, size_t N>
+        static
+        void get( digest_block dst, const U (&dat)[N] )
+        {
+            get_fixed<N * sizeof(U)>( dst, &dat[0] );
+        }
+
+        template <typename U, size_t N>
+        static
+        void get( digest_block dst, const std::array<U, N> &dat )
+        {
+            get_fixed<N * sizeof(U)>( dst, dat.data( ) );
+        }
+
+        static
+        void get_many( const slice *src, digest_block *dst, size_t count )
+        {
+            enum { chunk = 64 };
+            slice firsts[chunk];
+
+            sha256::get_many( src, dst, count );
+
+            /// in place is fine: the engine copies short messages into
+            /// its padding buffer before any digest is written
+            for( size_t i=0; i<count; i+=chunk ) {
+                size_t n = ( count - i < chunk ) ? count - i : size_t(chunk);
+                for( size_t j=0; j<n; ++j ) {
+                    firsts[j] = slice( dst[i + j], digest_length );
+                }
+                sha256::get_many( firsts, dst + i, n );
+            }
         }
     };
 
@@ -112,10 +286,112 @@ namespace bchain { namespace hash {
         {
             sha256::digest_block first_dst;
             sha256::get( first_dst, dat, len );
-            ripemd160::get( dst, first_dst, sha256::digest_length );
+            ripemd160_engine::ripemd160_32( first_dst, dst );
+        }
+
+        static
+        void get_many( const slice *src, digest_block *dst, size_t count )
+        {
+            enum { chunk = 64 };
+            sha256::digest_block firsts[chunk];
+
+            for( size_t i=0; i<count; i+=chunk ) {
+                size_t n = ( count - i < chunk ) ? count - i : size_t(chunk);
+                sha256::get_many( src + i, firsts, n );
+                for( size_t j=0; j<n; ++j ) {
+                    ripemd160_engine::ripemd160_32( firsts[j], dst[i + j] );
+                }
+            }
+        }
+    };
+
+
+    /// HMAC with both padded key blocks hashed up front. Every message
+    /// under the same key starts from the saved inner and outer
+    /// midstates, so a short message costs two compressions for itself
+    /// and two for the outer hash, never the key blocks again.
+    template <typename HashT, size_t BlockLen>
+    class hmac {
+
+    public:
+
+        enum { digest_length = HashT::digest_length };
+        enum { block_length  = BlockLen };
+        using digest_block   = typename HashT::digest_block;
+        using context        = typename HashT::context;
+
+        /// empty key
+        hmac( )
+        {
+            set_key( nullptr, 0 );
         }
+
+        hmac( const std::uint8_t *key, size_t len )
+        {
+            set_key( key, len );
+        }
+
+        ~hmac( )
+        {
+            OPENSSL_cleanse( &inner_, sizeof(inner_) );
+            OPENSSL_cleanse( &outer_, sizeof(outer_) );
+        }
+
+        void set_key( const std::uint8_t *key, size_t len )
+        {
+            std::uint8_t pad[block_length] = { 0 };
+            if( len > block_length ) {
+                HashT::get( pad, key, len );
+            } else if( len > 0 ) {
+                memcpy( pad, key, len );
+            }
+
+            for( auto &c: pad ) {
+                c ^= 0x36;
+            }
+            inner_ = context( );
+            inner_.update( pad, block_length );
+
+            for( auto &c: pad ) {
+                c ^= 0x36 ^ 0x5c;
+            }
+            outer_ = context( );
+            outer_.update( pad, block_length );
+
+            OPENSSL_cleanse( pad, sizeof(pad) );
+        }
+
+        /// Inner hash with the key block already absorbed. Update it with
+        /// the message and hand it to final( ).
+        context begin( ) const
+        {
+            return inner_;
+        }
+
+        void final( context &inner, digest_block dst ) const
+        {
+            inner.final( dst );
+            context outer(outer_);
+            outer.update( dst, digest_length );
+            outer.final( dst );
+        }
+
+        template <typename U>
+        void get( digest_block dst, const U *dat, size_t len ) const
+        {
+            context ctx(inner_);
+            ctx.update( dat, len );
+            final( ctx, dst );
+        }
+
+    private:
+        context inner_;
+        context outer_;
     };
 
+    using hmac_sha256 = hmac<sha256, sha256_engine::block_length>;
+    using hmac_sha512 = hmac<sha512, SHA512_CBLOCK>;
+
 } }
 
 #endif // HASH_H
@@ -221,9 +221,13 @@ int test_wif( )
 }
 
 int main_script( );
+int main_bench_hash( );
 
-int main( )
+int main( int argc, char *argv[] )
 {
+    if( argc > 1 && std::string(argv[1]) == "bench-hash" ) {
+        return main_bench_hash( );
+    }
     return main_script( );
 
     auto res = base58::decode_check(bomz);
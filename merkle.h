@@ -0,0 +1,399 @@
+#ifndef MERKLE_H
+#define MERKLE_H
+
+#include <cstdint>
+#include <vector>
+#include <array>
+#include <string>
+#include <iterator>
+#include <memory.h>
+
+#include "hash.h"
+#include "tx.h"
+#include "thread_pool.h"
+
+namespace bchain { namespace merkle {
+
+    /// hash256 in internal byte order (the txid as hashed, not as shown)
+    using digest_type = std::array<std::uint8_t, hash::hash256::digest_length>;
+
+    inline
+    digest_type txid( const tx::transaction &t )
+    {
+        return t.txid( );
+    }
+
+    inline
+    const digest_type &leaf_of( const digest_type &id )
+    {
+        return id;
+    }
+
+    inline
+    digest_type leaf_of( const tx::transaction &t )
+    {
+        return txid( t );
+    }
+
+    struct level {
+
+        /// pairs handed to a single worker
+        enum { grain = 512 };
+
+        static
+        std::size_t parent_count( std::size_t count )
+        {
+            return ( count + 1 ) / 2;
+        }
+
+        /// Hashes 'count' nodes into parent_count(count) parents. An odd
+        /// last node is paired with itself. 'dst' may be 'src'; otherwise
+        /// the pairs are spread over 'pool' or the common pool.
+        static
+        void hash( const digest_type *src, std::size_t count,
+                   digest_type *dst, thread_pool *pool = nullptr )
+        {
+            std::size_t parents = parent_count( count );
+            if( parents == 0 ) {
+                return;
+            }
+
+            /// the duplicated tail pair is the only one not contiguous
+            std::size_t full = count / 2;
+            digest_type tail;
+            if( count % 2 ) {
+                std::uint8_t pair[hash::hash256::digest_length * 2];
+                memcpy( pair, src[count - 1].data( ), tail.size( ) );
+                memcpy( pair + tail.size( ), src[count - 1].data( ),
+                        tail.size( ) );
+                hash::hash256::get( tail.data( ), pair );
+            }
+
+            /// in place, chunk [b, e) writes dst[b, e) while reading
+            /// src[2b, 2e), so chunks must run in order
+            if( dst != src ) {
+                thread_pool &tp = pool ? *pool : thread_pool::common( );
+                tp.parallel_for( full, grain,
+                    [src, dst]( std::size_t b, std::size_t e ) {
+                        hash_pairs( src, dst, b, e );
+                    } );
+            } else {
+                hash_pairs( src, dst, 0, full );
+            }
+
+            if( count % 2 ) {
+                dst[parents - 1] = tail;
+            }
+        }
+
+    private:
+
+        static
+        void hash_pairs( const digest_type *src, digest_type *dst,
+                         std::size_t b, std::size_t e )
+        {
+            enum { chunk = 64 };
+            using slice = hash::hash256::slice;
+            using block = hash::hash256::digest_block;
+
+            slice  pairs[chunk];
+            block  out[chunk];
+
+            while( b < e ) {
+                std::size_t n = ( e - b < chunk ) ? e - b : std::size_t(chunk);
+                for( std::size_t i=0; i<n; ++i ) {
+                    pairs[i] = slice( src[( b + i ) * 2].data( ),
+                                      hash::hash256::digest_length * 2 );
+                }
+                hash::hash256::get_many( pairs, out, n );
+                for( std::size_t i=0; i<n; ++i ) {
+                    memcpy( dst[b + i].data( ), out[i],
+                            hash::hash256::digest_length );
+                }
+                b += n;
+            }
+        }
+    };
+
+    /// Inclusion proof: the sibling hashes from the leaf level upward.
+    struct proof {
+
+        std::size_t              index = 0;
+        std::vector<digest_type> branch;
+
+        digest_type root_from( const digest_type &leaf ) const
+        {
+            std::uint8_t pair[hash::hash256::digest_length * 2];
+            digest_type  res = leaf;
+            std::size_t  idx = index;
+            const std::size_t half = res.size( );
+
+            for( auto &sibling: branch ) {
+                if( idx & 1 ) {
+                    memcpy( pair,        sibling.data( ), half );
+                    memcpy( pair + half, res.data( ),     half );
+                } else {
+                    memcpy( pair,        res.data( ),     half );
+                    memcpy( pair + half, sibling.data( ), half );
+                }
+                hash::hash256::get( res.data( ), pair );
+                idx >>= 1;
+            }
+            return res;
+        }
+
+        bool verify( const digest_type &leaf, const digest_type &root ) const
+        {
+            return root_from( leaf ) == root;
+        }
+    };
+
+    struct tree {
+
+        template <typename Itr>
+        static
+        std::vector<digest_type> leaves( Itr begin, Itr end )
+        {
+            std::vector<digest_type> res;
+            res.reserve( static_cast<std::size_t>(std::distance(begin, end)) );
+            for( ; begin != end; ++begin ) {
+                res.push_back( leaf_of( *begin ) );
+            }
+            return res;
+        }
+
+        /// Root over transactions or txids. An empty range gives all
+        /// zeroes.
+        template <typename Itr>
+        static
+        digest_type root( Itr begin, Itr end, thread_pool *pool = nullptr )
+        {
+            return root_of( leaves( begin, end ), pool );
+        }
+
+        static
+        digest_type root_of( std::vector<digest_type> nodes,
+                             thread_pool *pool = nullptr )
+        {
+            if( nodes.empty( ) ) {
+                digest_type zero;
+                zero.fill( 0 );
+                return zero;
+            }
+
+            std::vector<digest_type> next;
+            while( nodes.size( ) > 1 ) {
+                next.resize( level::parent_count( nodes.size( ) ) );
+                level::hash( nodes.data( ), nodes.size( ), next.data( ),
+                             pool );
+                nodes.swap( next );
+            }
+            return nodes[0];
+        }
+
+        template <typename Itr>
+        static
+        proof make_proof( Itr begin, Itr end, std::size_t index,
+                          thread_pool *pool = nullptr )
+        {
+            return make_proof_of( leaves( begin, end ), index, pool );
+        }
+
+        static
+        proof make_proof_of( std::vector<digest_type> nodes,
+                             std::size_t index, thread_pool *pool = nullptr )
+        {
+            proof res;
+            res.index = index;
+            if( index >= nodes.size( ) ) {
+                return res;
+            }
+
+            std::vector<digest_type> next;
+            while( nodes.size( ) > 1 ) {
+                std::size_t sibling = index ^ 1;
+                if( sibling >= nodes.size( ) ) {
+                    sibling = index;
+                }
+                res.branch.push_back( nodes[sibling] );
+
+                next.resize( level::parent_count( nodes.size( ) ) );
+                level::hash( nodes.data( ), nodes.size( ), next.data( ),
+                             pool );
+                nodes.swap( next );
+                index >>= 1;
+            }
+            return res;
+        }
+    };
+
+    /// Merkle tree over a mutating leaf set. Every level is kept, so
+    /// appending, replacing or swap-removing a leaf rehashes only the
+    /// nodes on its path to the root.
+    class incremental {
+
+    public:
+
+        incremental( ) = default;
+
+        template <typename Itr>
+        incremental( Itr begin, Itr end, thread_pool *pool = nullptr )
+        {
+            levels_.push_back( tree::leaves( begin, end ) );
+            while( levels_.back( ).size( ) > 1 ) {
+                auto &last = levels_.back( );
+                std::vector<digest_type> next(level::parent_count(last.size( )));
+                level::hash( last.data( ), last.size( ), next.data( ), pool );
+                levels_.push_back( std::move(next) );
+            }
+        }
+
+        std::size_t size( ) const
+        {
+            return levels_.empty( ) ? 0 : levels_[0].size( );
+        }
+
+        bool empty( ) const
+        {
+            return size( ) == 0;
+        }
+
+        const digest_type &leaf( std::size_t index ) const
+        {
+            return levels_[0][index];
+        }
+
+        /// All zeroes when there are no leaves.
+        digest_type root( ) const
+        {
+            if( empty( ) ) {
+                digest_type zero;
+                zero.fill( 0 );
+                return zero;
+            }
+            return levels_.back( )[0];
+        }
+
+        void append( const digest_type &leaf )
+        {
+            if( levels_.empty( ) ) {
+                levels_.resize( 1 );
+            }
+            levels_[0].push_back( leaf );
+            fit_levels( );
+            update_path( levels_[0].size( ) - 1 );
+        }
+
+        void append( const tx::transaction &t )
+        {
+            append( txid( t ) );
+        }
+
+        void replace( std::size_t index, const digest_type &leaf )
+        {
+            levels_[0][index] = leaf;
+            update_path( index );
+        }
+
+        void replace( std::size_t index, const tx::transaction &t )
+        {
+            replace( index, txid( t ) );
+        }
+
+        /// O(log n) removal: the last leaf takes the place of the removed
+        /// one, so leaf order is not kept.
+        void remove_swap( std::size_t index )
+        {
+            auto &leaves = levels_[0];
+            std::size_t last = leaves.size( ) - 1;
+
+            leaves[index] = leaves[last];
+            leaves.pop_back( );
+            fit_levels( );
+
+            if( index < last ) {
+                update_path( index );
+            }
+            if( !leaves.empty( ) ) {
+                update_path( leaves.size( ) - 1 );
+            }
+        }
+
+        /// Order-preserving removal; every node right of the removed leaf
+        /// moves, so this costs O(n - index).
+        void erase( std::size_t index )
+        {
+            auto &leaves = levels_[0];
+            leaves.erase( leaves.begin( ) + static_cast<long>(index) );
+            fit_levels( );
+
+            std::size_t from = index;
+            for( std::size_t k=0; k+1<levels_.size( ); ++k ) {
+                from /= 2;
+                for( std::size_t p=from; p<levels_[k + 1].size( ); ++p ) {
+                    hash_node( k, p );
+                }
+            }
+        }
+
+        proof make_proof( std::size_t index ) const
+        {
+            proof res;
+            res.index = index;
+            for( std::size_t k=0; k+1<levels_.size( ); ++k ) {
+                std::size_t sibling = index ^ 1;
+                if( sibling >= levels_[k].size( ) ) {
+                    sibling = index;
+                }
+                res.branch.push_back( levels_[k][sibling] );
+                index >>= 1;
+            }
+            return res;
+        }
+
+    private:
+
+        /// Resizes the upper levels to match the leaf count. New slots are
+        /// filled by the update_path call that follows.
+        void fit_levels( )
+        {
+            std::size_t k = 0;
+            for( ; levels_[k].size( ) > 1; ++k ) {
+                if( k + 1 == levels_.size( ) ) {
+                    levels_.resize( k + 2 );
+                }
+                levels_[k + 1].resize( level::parent_count(levels_[k].size( )) );
+            }
+            levels_.resize( k + 1 );
+        }
+
+        void hash_node( std::size_t k, std::size_t p )
+        {
+            auto &src = levels_[k];
+            auto &dst = levels_[k + 1][p];
+            std::size_t left = p * 2;
+
+            if( left + 1 < src.size( ) ) {
+                hash::hash256::get_fixed<64>( dst.data( ), src[left].data( ) );
+            } else {
+                std::uint8_t pair[hash::hash256::digest_length * 2];
+                memcpy( pair, src[left].data( ), dst.size( ) );
+                memcpy( pair + dst.size( ), src[left].data( ), dst.size( ) );
+                hash::hash256::get( dst.data( ), pair );
+            }
+        }
+
+        void update_path( std::size_t index )
+        {
+            for( std::size_t k=0; k+1<levels_.size( ); ++k ) {
+                index /= 2;
+                hash_node( k, index );
+            }
+        }
+
+        std::vector<std::vector<digest_type> > levels_;
+    };
+
+}}
+
+#endif // MERKLE_H
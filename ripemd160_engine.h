@@ -0,0 +1,286 @@
+#ifndef RIPEMD160_ENGINE_H
+#define RIPEMD160_ENGINE_H
+
+#include <cstdint>
+#include <cstddef>
+
+namespace bchain { namespace hash {
+
+    /// Portable RIPEMD-160 compression. Only the fixed 32-byte message of
+    /// hash160 (RIPEMD-160 over a SHA-256 digest) is exposed: its single
+    /// padded block is built in place, with no Init/Update/Final.
+    struct ripemd160_engine {
+
+        enum { digest_length = 20 };
+
+        static
+        void ripemd160_32( const std::uint8_t *src, std::uint8_t *dst )
+        {
+            std::uint32_t x[16];
+            for( int i=0; i<8; ++i ) {
+                x[i] = read_le32( src + i * 4 );
+            }
+            x[8] = 0x80;
+            for( int i=9; i<14; ++i ) {
+                x[i] = 0;
+            }
+            x[14] = 32 * 8;
+            x[15] = 0;
+
+            std::uint32_t h[5] = {
+                0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0,
+            };
+            compress( h, x );
+            for( int i=0; i<5; ++i ) {
+                write_le32( h[i], dst + i * 4 );
+            }
+        }
+
+        static
+        void compress( std::uint32_t h[5], const std::uint32_t x[16] )
+        {
+            static const std::uint32_t kl[5] = {
+                0x00000000, 0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xA953FD4E,
+            };
+            static const std::uint32_t kr[5] = {
+                0x50A28BE6, 0x5C4DD124, 0x6D703EF3, 0x7A6D76E9, 0x00000000,
+            };
+
+            std::uint32_t al = h[0], bl = h[1], cl = h[2], dl = h[3], el = h[4];
+            std::uint32_t ar = h[0], br = h[1], cr = h[2], dr = h[3], er = h[4];
+
+            /// Fully unrolled; instead of shifting five registers per step
+            /// the names rotate from one call to the next.
+
+            /// round 1: f1 on the left, f5 on the right
+            step<0>( al, bl, cl, dl, el, x[ 0], 11, kl[0] );
+            step<4>( ar, br, cr, dr, er, x[ 5],  8, kr[0] );
+            step<0>( el, al, bl, cl, dl, x[ 1], 14, kl[0] );
+            step<4>( er, ar, br, cr, dr, x[14],  9, kr[0] );
+            step<0>( dl, el, al, bl, cl, x[ 2], 15, kl[0] );
+            step<4>( dr, er, ar, br, cr, x[ 7],  9, kr[0] );
+            step<0>( cl, dl, el, al, bl, x[ 3], 12, kl[0] );
+            step<4>( cr, dr, er, ar, br, x[ 0], 11, kr[0] );
+            step<0>( bl, cl, dl, el, al, x[ 4],  5, kl[0] );
+            step<4>( br, cr, dr, er, ar, x[ 9], 13, kr[0] );
+            step<0>( al, bl, cl, dl, el, x[ 5],  8, kl[0] );
+            step<4>( ar, br, cr, dr, er, x[ 2], 15, kr[0] );
+            step<0>( el, al, bl, cl, dl, x[ 6],  7, kl[0] );
+            step<4>( er, ar, br, cr, dr, x[11], 15, kr[0] );
+            step<0>( dl, el, al, bl, cl, x[ 7],  9, kl[0] );
+            step<4>( dr, er, ar, br, cr, x[ 4],  5, kr[0] );
+            step<0>( cl, dl, el, al, bl, x[ 8], 11, kl[0] );
+            step<4>( cr, dr, er, ar, br, x[13],  7, kr[0] );
+            step<0>( bl, cl, dl, el, al, x[ 9], 13, kl[0] );
+            step<4>( br, cr, dr, er, ar, x[ 6],  7, kr[0] );
+            step<0>( al, bl, cl, dl, el, x[10], 14, kl[0] );
+            step<4>( ar, br, cr, dr, er, x[15],  8, kr[0] );
+            step<0>( el, al, bl, cl, dl, x[11], 15, kl[0] );
+            step<4>( er, ar, br, cr, dr, x[ 8], 11, kr[0] );
+            step<0>( dl, el, al, bl, cl, x[12],  6, kl[0] );
+            step<4>( dr, er, ar, br, cr, x[ 1], 14, kr[0] );
+            step<0>( cl, dl, el, al, bl, x[13],  7, kl[0] );
+            step<4>( cr, dr, er, ar, br, x[10], 14, kr[0] );
+            step<0>( bl, cl, dl, el, al, x[14],  9, kl[0] );
+            step<4>( br, cr, dr, er, ar, x[ 3], 12, kr[0] );
+            step<0>( al, bl, cl, dl, el, x[15],  8, kl[0] );
+            step<4>( ar, br, cr, dr, er, x[12],  6, kr[0] );
+
+            /// round 2: f2 on the left, f4 on the right
+            step<1>( el, al, bl, cl, dl, x[ 7],  7, kl[1] );
+            step<3>( er, ar, br, cr, dr, x[ 6],  9, kr[1] );
+            step<1>( dl, el, al, bl, cl, x[ 4],  6, kl[1] );
+            step<3>( dr, er, ar, br, cr, x[11], 13, kr[1] );
+            step<1>( cl, dl, el, al, bl, x[13],  8, kl[1] );
+            step<3>( cr, dr, er, ar, br, x[ 3], 15, kr[1] );
+            step<1>( bl, cl, dl, el, al, x[ 1], 13, kl[1] );
+            step<3>( br, cr, dr, er, ar, x[ 7],  7, kr[1] );
+            step<1>( al, bl, cl, dl, el, x[10], 11, kl[1] );
+            step<3>( ar, br, cr, dr, er, x[ 0], 12, kr[1] );
+            step<1>( el, al, bl, cl, dl, x[ 6],  9, kl[1] );
+            step<3>( er, ar, br, cr, dr, x[13],  8, kr[1] );
+            step<1>( dl, el, al, bl, cl, x[15],  7, kl[1] );
+            step<3>( dr, er, ar, br, cr, x[ 5],  9, kr[1] );
+            step<1>( cl, dl, el, al, bl, x[ 3], 15, kl[1] );
+            step<3>( cr, dr, er, ar, br, x[10], 11, kr[1] );
+            step<1>( bl, cl, dl, el, al, x[12],  7, kl[1] );
+            step<3>( br, cr, dr, er, ar, x[14],  7, kr[1] );
+            step<1>( al, bl, cl, dl, el, x[ 0], 12, kl[1] );
+            step<3>( ar, br, cr, dr, er, x[15],  7, kr[1] );
+            step<1>( el, al, bl, cl, dl, x[ 9], 15, kl[1] );
+            step<3>( er, ar, br, cr, dr, x[ 8], 12, kr[1] );
+            step<1>( dl, el, al, bl, cl, x[ 5],  9, kl[1] );
+            step<3>( dr, er, ar, br, cr, x[12],  7, kr[1] );
+            step<1>( cl, dl, el, al, bl, x[ 2], 11, kl[1] );
+            step<3>( cr, dr, er, ar, br, x[ 4],  6, kr[1] );
+            step<1>( bl, cl, dl, el, al, x[14],  7, kl[1] );
+            step<3>( br, cr, dr, er, ar, x[ 9], 15, kr[1] );
+            step<1>( al, bl, cl, dl, el, x[11], 13, kl[1] );
+            step<3>( ar, br, cr, dr, er, x[ 1], 13, kr[1] );
+            step<1>( el, al, bl, cl, dl, x[ 8], 12, kl[1] );
+            step<3>( er, ar, br, cr, dr, x[ 2], 11, kr[1] );
+
+            /// round 3: f3 on the left, f3 on the right
+            step<2>( dl, el, al, bl, cl, x[ 3], 11, kl[2] );
+            step<2>( dr, er, ar, br, cr, x[15],  9, kr[2] );
+            step<2>( cl, dl, el, al, bl, x[10], 13, kl[2] );
+            step<2>( cr, dr, er, ar, br, x[ 5],  7, kr[2] );
+            step<2>( bl, cl, dl, el, al, x[14],  6, kl[2] );
+            step<2>( br, cr, dr, er, ar, x[ 1], 15, kr[2] );
+            step<2>( al, bl, cl, dl, el, x[ 4],  7, kl[2] );
+            step<2>( ar, br, cr, dr, er, x[ 3], 11, kr[2] );
+            step<2>( el, al, bl, cl, dl, x[ 9], 14, kl[2] );
+            step<2>( er, ar, br, cr, dr, x[ 7],  8, kr[2] );
+            step<2>( dl, el, al, bl, cl, x[15],  9, kl[2] );
+            step<2>( dr, er, ar, br, cr, x[14],  6, kr[2] );
+            step<2>( cl, dl, el, al, bl, x[ 8], 13, kl[2] );
+            step<2>( cr, dr, er, ar, br, x[ 6],  6, kr[2] );
+            step<2>( bl, cl, dl, el, al, x[ 1], 15, kl[2] );
+            step<2>( br, cr, dr, er, ar, x[ 9], 14, kr[2] );
+            step<2>( al, bl, cl, dl, el, x[ 2], 14, kl[2] );
+            step<2>( ar, br, cr, dr, er, x[11], 12, kr[2] );
+            step<2>( el, al, bl, cl, dl, x[ 7],  8, kl[2] );
+            step<2>( er, ar, br, cr, dr, x[ 8], 13, kr[2] );
+            step<2>( dl, el, al, bl, cl, x[ 0], 13, kl[2] );
+            step<2>( dr, er, ar, br, cr, x[12],  5, kr[2] );
+            step<2>( cl, dl, el, al, bl, x[ 6],  6, kl[2] );
+            step<2>( cr, dr, er, ar, br, x[ 2], 14, kr[2] );
+            step<2>( bl, cl, dl, el, al, x[13],  5, kl[2] );
+            step<2>( br, cr, dr, er, ar, x[10], 13, kr[2] );
+            step<2>( al, bl, cl, dl, el, x[11], 12, kl[2] );
+            step<2>( ar, br, cr, dr, er, x[ 0], 13, kr[2] );
+            step<2>( el, al, bl, cl, dl, x[ 5],  7, kl[2] );
+            step<2>( er, ar, br, cr, dr, x[ 4],  7, kr[2] );
+            step<2>( dl, el, al, bl, cl, x[12],  5, kl[2] );
+            step<2>( dr, er, ar, br, cr, x[13],  5, kr[2] );
+
+            /// round 4: f4 on the left, f2 on the right
+            step<3>( cl, dl, el, al, bl, x[ 1], 11, kl[3] );
+            step<1>( cr, dr, er, ar, br, x[ 8], 15, kr[3] );
+            step<3>( bl, cl, dl, el, al, x[ 9], 12, kl[3] );
+            step<1>( br, cr, dr, er, ar, x[ 6],  5, kr[3] );
+            step<3>( al, bl, cl, dl, el, x[11], 14, kl[3] );
+            step<1>( ar, br, cr, dr, er, x[ 4],  8, kr[3] );
+            step<3>( el, al, bl, cl, dl, x[10], 15, kl[3] );
+            step<1>( er, ar, br, cr, dr, x[ 1], 11, kr[3] );
+            step<3>( dl, el, al, bl, cl, x[ 0], 14, kl[3] );
+            step<1>( dr, er, ar, br, cr, x[ 3], 14, kr[3] );
+            step<3>( cl, dl, el, al, bl, x[ 8], 15, kl[3] );
+            step<1>( cr, dr, er, ar, br, x[11], 14, kr[3] );
+            step<3>( bl, cl, dl, el, al, x[12],  9, kl[3] );
+            step<1>( br, cr, dr, er, ar, x[15],  6, kr[3] );
+            step<3>( al, bl, cl, dl, el, x[ 4],  8, kl[3] );
+            step<1>( ar, br, cr, dr, er, x[ 0], 14, kr[3] );
+            step<3>( el, al, bl, cl, dl, x[13],  9, kl[3] );
+            step<1>( er, ar, br, cr, dr, x[ 5],  6, kr[3] );
+            step<3>( dl, el, al, bl, cl, x[ 3], 14, kl[3] );
+            step<1>( dr, er, ar, br, cr, x[12],  9, kr[3] );
+            step<3>( cl, dl, el, al, bl, x[ 7],  5, kl[3] );
+            step<1>( cr, dr, er, ar, br, x[ 2], 12, kr[3] );
+            step<3>( bl, cl, dl, el, al, x[15],  6, kl[3] );
+            step<1>( br, cr, dr, er, ar, x[13],  9, kr[3] );
+            step<3>( al, bl, cl, dl, el, x[14],  8, kl[3] );
+            step<1>( ar, br, cr, dr, er, x[ 9], 12, kr[3] );
+            step<3>( el, al, bl, cl, dl, x[ 5],  6, kl[3] );
+            step<1>( er, ar, br, cr, dr, x[ 7],  5, kr[3] );
+            step<3>( dl, el, al, bl, cl, x[ 6],  5, kl[3] );
+            step<1>( dr, er, ar, br, cr, x[10], 15, kr[3] );
+            step<3>( cl, dl, el, al, bl, x[ 2], 12, kl[3] );
+            step<1>( cr, dr, er, ar, br, x[14],  8, kr[3] );
+
+            /// round 5: f5 on the left, f1 on the right
+            step<4>( bl, cl, dl, el, al, x[ 4],  9, kl[4] );
+            step<0>( br, cr, dr, er, ar, x[12],  8, kr[4] );
+            step<4>( al, bl, cl, dl, el, x[ 0], 15, kl[4] );
+            step<0>( ar, br, cr, dr, er, x[15],  5, kr[4] );
+            step<4>( el, al, bl, cl, dl, x[ 5],  5, kl[4] );
+            step<0>( er, ar, br, cr, dr, x[10], 12, kr[4] );
+            step<4>( dl, el, al, bl, cl, x[ 9], 11, kl[4] );
+            step<0>( dr, er, ar, br, cr, x[ 4],  9, kr[4] );
+            step<4>( cl, dl, el, al, bl, x[ 7],  6, kl[4] );
+            step<0>( cr, dr, er, ar, br, x[ 1], 12, kr[4] );
+            step<4>( bl, cl, dl, el, al, x[12],  8, kl[4] );
+            step<0>( br, cr, dr, er, ar, x[ 5],  5, kr[4] );
+            step<4>( al, bl, cl, dl, el, x[ 2], 13, kl[4] );
+            step<0>( ar, br, cr, dr, er, x[ 8], 14, kr[4] );
+            step<4>( el, al, bl, cl, dl, x[10], 12, kl[4] );
+            step<0>( er, ar, br, cr, dr, x[ 7],  6, kr[4] );
+            step<4>( dl, el, al, bl, cl, x[14],  5, kl[4] );
+            step<0>( dr, er, ar, br, cr, x[ 6],  8, kr[4] );
+            step<4>( cl, dl, el, al, bl, x[ 1], 12, kl[4] );
+            step<0>( cr, dr, er, ar, br, x[ 2], 13, kr[4] );
+            step<4>( bl, cl, dl, el, al, x[ 3], 13, kl[4] );
+            step<0>( br, cr, dr, er, ar, x[13],  6, kr[4] );
+            step<4>( al, bl, cl, dl, el, x[ 8], 14, kl[4] );
+            step<0>( ar, br, cr, dr, er, x[14],  5, kr[4] );
+            step<4>( el, al, bl, cl, dl, x[11], 11, kl[4] );
+            step<0>( er, ar, br, cr, dr, x[ 0], 15, kr[4] );
+            step<4>( dl, el, al, bl, cl, x[ 6],  8, kl[4] );
+            step<0>( dr, er, ar, br, cr, x[ 3], 13, kr[4] );
+            step<4>( cl, dl, el, al, bl, x[15],  5, kl[4] );
+            step<0>( cr, dr, er, ar, br, x[ 9], 11, kr[4] );
+            step<4>( bl, cl, dl, el, al, x[13],  6, kl[4] );
+            step<0>( br, cr, dr, er, ar, x[11], 11, kr[4] );
+
+            std::uint32_t t = h[1] + cl + dr;
+            h[1] = h[2] + dl + er;
+            h[2] = h[3] + el + ar;
+            h[3] = h[4] + al + br;
+            h[4] = h[0] + bl + cr;
+            h[0] = t;
+        }
+
+    private:
+
+        template <int F>
+        static
+        std::uint32_t f( std::uint32_t x, std::uint32_t y, std::uint32_t z )
+        {
+            switch( F ) {
+            case 0:  return x ^ y ^ z;
+            case 1:  return ( x & y ) | ( ~x & z );
+            case 2:  return ( x | ~y ) ^ z;
+            case 3:  return ( x & z ) | ( y & ~z );
+            default: return x ^ ( y | ~z );
+            }
+        }
+
+        /// one step of either line with f_F; 'a' takes the new value
+        template <int F>
+        static
+        void step( std::uint32_t &a, std::uint32_t b, std::uint32_t &c,
+                   std::uint32_t d, std::uint32_t e, std::uint32_t x,
+                   unsigned s, std::uint32_t k )
+        {
+            a = rotl( a + f<F>( b, c, d ) + x + k, s ) + e;
+            c = rotl( c, 10 );
+        }
+
+        static
+        std::uint32_t rotl( std::uint32_t v, unsigned n )
+        {
+            return ( v << n ) | ( v >> ( 32 - n ) );
+        }
+
+        static
+        std::uint32_t read_le32( const std::uint8_t *p )
+        {
+            return ( static_cast<std::uint32_t>(p[0])       )
+                 | ( static_cast<std::uint32_t>(p[1]) <<  8 )
+                 | ( static_cast<std::uint32_t>(p[2]) << 16 )
+                 | ( static_cast<std::uint32_t>(p[3]) << 24 );
+        }
+
+        static
+        void write_le32( std::uint32_t val, std::uint8_t *p )
+        {
+            p[0] = static_cast<std::uint8_t>(val      );
+            p[1] = static_cast<std::uint8_t>(val >>  8);
+            p[2] = static_cast<std::uint8_t>(val >> 16);
+            p[3] = static_cast<std::uint8_t>(val >> 24);
+        }
+    };
+
+}}
+
+#endif // RIPEMD160_ENGINE_H
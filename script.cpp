@@ -14,6 +14,8 @@
 
 #include "hash.h"
 #include "tx.h"
+#include "sighash.h"
+#include "signer.h"
 
 namespace {
 
@@ -292,7 +294,6 @@ int main_script0( )
     tx::input       ins_sign[1];
     tx::outpoint    outpoint;
     tx::transaction tx;
-    std::size_t     msg_len;
 
     const char msg_exp[] = "0100000001f3a27f485f9833c8318c490403307f"
                            "ef1397121b5dd8fe70777236e7371c4ef3000000"
@@ -308,31 +309,30 @@ int main_script0( )
     outpoint.fill( "f34e1c37e736727770fed85d1b129713"
                    "ef7f300304498c31c833985f487fa2f3"_bin, 0 );
     prev_outs[0].fill( 87000000, "6bf19e55f94d986b4640c154d864699341919511"_bin );
-    ins_sign[0].fill_signable( outpoint, prev_outs[0] );
-
-    tx.tx_out.push_back( outs[0] );
-    tx.tx_out.push_back( outs[1] );
-    tx.tx_in.push_back( ins_sign[0] );
-    tx.locktime = 0;
-    tx.version = 1;
-    msg_len = tx.size( tx::SIGHASH_ALL );
+    ins_sign[0].fill_truncated( outpoint );
+
+    tx.add_output( outs[0] );
+    tx.add_output( outs[1] );
+    tx.add_input( ins_sign[0] );
+    tx.set_locktime( 0 );
+    tx.set_version( 1 );
+
+    tx::sighash_engine engine(tx);
     std::string res;
-    tx.serialize_to( tx::SIGHASH_ALL, res );
+    tx::string_writer rw(res);
+    engine.write_legacy( 0, prev_outs[0].script, tx::SIGHASH_ALL, rw );
 
     std::cout << msg_exp << "\n";
     printhex(std::cout, res) << "\n";
 
-    //res = *details::byte_hex::to_hex( res );
-    auto h = hash::hash256::get_string( res.c_str( ), res.size( ) );
-
     auto k = crypto::ec_key::create_private( priv_bytes, sizeof(priv_bytes) );
-    auto s = crypto::signature::hash_and_sign( h.c_str( ), h.size( ), k.get( ));
+    k.set_conv_compressed( true );
 
-    auto der = s.to_der( k.get( ) );
-
-    tx.tx_in[0].fill( outpoint, der,
-                      std::string(pub_bytes, pub_bytes+sizeof(pub_bytes)),
-                      tx::SIGHASH_ALL );
+    tx::signer sig(tx);
+    sig.set_input( 0, prev_outs[0], k );
+    if( !sig.sign( tx::SIGHASH_ALL ) ) {
+        return 1;
+    }
 
     res.clear( );
     tx.serialize_to( tx::SIGHASH_NON, res );
@@ -0,0 +1,1372 @@
+#ifndef SECP256K1_H
+#define SECP256K1_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <initializer_list>
+#include <memory.h>
+
+#include "openssl/sha.h"
+
+#if !defined(__SIZEOF_INT128__)
+#   error "the native secp256k1 backend needs unsigned __int128"
+#endif
+
+namespace bchain { namespace secp256k1 {
+
+    using uint128 = unsigned __int128;
+
+    /// Field element mod p = 2^256 - 2^32 - 977 as five 52-bit limbs (the
+    /// top one 48 bits). Limbs may run above their width between
+    /// normalisations; the 'magnitude' m of an element bounds every limb
+    /// by 2 * m * (2^52 - 1). add( ) sums magnitudes, mul( ) and sqr( )
+    /// take up to 8 and return 1.
+    struct fe {
+
+        std::uint64_t n[5];
+
+        enum : std::uint64_t {
+            M52 = 0xFFFFFFFFFFFFFULL,
+            M48 = 0xFFFFFFFFFFFFULL,
+            P0  = 0xFFFFEFFFFFC2FULL,
+            R   = 0x1000003D1ULL,  /// 2^256 mod p
+            R52 = 0x1000003D10ULL, /// 2^260 mod p
+        };
+
+        static
+        fe from_int( std::uint64_t v )
+        {
+            fe r = { { v, 0, 0, 0, 0 } };
+            return r;
+        }
+
+        /// false if the value is not below p
+        static
+        bool set_bytes( fe &r, const std::uint8_t *b32 )
+        {
+            std::uint64_t w[4];
+            for( int i=0; i<4; ++i ) {
+                w[3 - i] = load_be64( b32 + i * 8 );
+            }
+            r.n[0] =  w[0] & M52;
+            r.n[1] = ( w[0] >> 52 | w[1] << 12 ) & M52;
+            r.n[2] = ( w[1] >> 40 | w[2] << 24 ) & M52;
+            r.n[3] = ( w[2] >> 28 | w[3] << 36 ) & M52;
+            r.n[4] =   w[3] >> 16;
+            return !( r.n[4] == M48 && ( r.n[3] & r.n[2] & r.n[1] ) == M52
+                      && r.n[0] >= P0 );
+        }
+
+        /// needs a normalized element
+        void get_bytes( std::uint8_t *b32 ) const
+        {
+            store_be64( b32 + 24, n[0] | n[1] << 52 );
+            store_be64( b32 + 16, n[1] >> 12 | n[2] << 40 );
+            store_be64( b32 +  8, n[2] >> 24 | n[3] << 28 );
+            store_be64( b32,      n[3] >> 36 | n[4] << 16 );
+        }
+
+        /// Fully reduces into [0, p).
+        void normalize( )
+        {
+            std::uint64_t t0 = n[0], t1 = n[1], t2 = n[2], t3 = n[3];
+            std::uint64_t t4 = n[4];
+
+            std::uint64_t x = t4 >> 48;
+            t4 &= M48;
+            t0 += x * R;
+            t1 += t0 >> 52; t0 &= M52;
+            t2 += t1 >> 52; t1 &= M52; std::uint64_t m = t1;
+            t3 += t2 >> 52; t2 &= M52; m &= t2;
+            t4 += t3 >> 52; t3 &= M52; m &= t3;
+
+            x = ( t4 >> 48 ) | ( ( t4 == M48 ) & ( m == M52 )
+                                 & ( t0 >= P0 ) );
+            t0 += x * R;
+            t1 += t0 >> 52; t0 &= M52;
+            t2 += t1 >> 52; t1 &= M52;
+            t3 += t2 >> 52; t2 &= M52;
+            t4 += t3 >> 52; t3 &= M52;
+            t4 &= M48;
+
+            n[0] = t0; n[1] = t1; n[2] = t2; n[3] = t3; n[4] = t4;
+        }
+
+        /// Brings the magnitude back to 1 without a full reduction.
+        void normalize_weak( )
+        {
+            std::uint64_t x = n[4] >> 48;
+            n[4] &= M48;
+            n[0] += x * R;
+            n[1] += n[0] >> 52; n[0] &= M52;
+            n[2] += n[1] >> 52; n[1] &= M52;
+            n[3] += n[2] >> 52; n[2] &= M52;
+            n[4] += n[3] >> 52; n[3] &= M52;
+        }
+
+        /// needs a normalized element
+        bool is_zero( ) const
+        {
+            return ( n[0] | n[1] | n[2] | n[3] | n[4] ) == 0;
+        }
+
+        /// needs a normalized element
+        bool is_odd( ) const
+        {
+            return n[0] & 1;
+        }
+
+        bool normalizes_to_zero( ) const
+        {
+            fe t = *this;
+            t.normalize( );
+            return t.is_zero( );
+        }
+
+        static
+        bool equal( fe a, fe b )
+        {
+            a.normalize( );
+            b.normalize( );
+            return ( ( a.n[0] ^ b.n[0] ) | ( a.n[1] ^ b.n[1] )
+                   | ( a.n[2] ^ b.n[2] ) | ( a.n[3] ^ b.n[3] )
+                   | ( a.n[4] ^ b.n[4] ) ) == 0;
+        }
+
+        void add( const fe &a )
+        {
+            for( int i=0; i<5; ++i ) {
+                n[i] += a.n[i];
+            }
+        }
+
+        void mul_int( std::uint64_t k )
+        {
+            for( int i=0; i<5; ++i ) {
+                n[i] *= k;
+            }
+        }
+
+        /// -a with magnitude m + 1; 'm' must not be below a's magnitude
+        static
+        fe negate( const fe &a, std::uint64_t m )
+        {
+            fe r;
+            std::uint64_t k = 2 * ( m + 1 );
+            r.n[0] = P0  * k - a.n[0];
+            r.n[1] = M52 * k - a.n[1];
+            r.n[2] = M52 * k - a.n[2];
+            r.n[3] = M52 * k - a.n[3];
+            r.n[4] = M48 * k - a.n[4];
+            return r;
+        }
+
+        static
+        fe mul( const fe &a, const fe &b )
+        {
+            const std::uint64_t *x = a.n;
+            const std::uint64_t *y = b.n;
+            uint128 t[9];
+
+            t[0] = (uint128)x[0] * y[0];
+            t[1] = (uint128)x[0] * y[1] + (uint128)x[1] * y[0];
+            t[2] = (uint128)x[0] * y[2] + (uint128)x[1] * y[1]
+                 + (uint128)x[2] * y[0];
+            t[3] = (uint128)x[0] * y[3] + (uint128)x[1] * y[2]
+                 + (uint128)x[2] * y[1] + (uint128)x[3] * y[0];
+            t[4] = (uint128)x[0] * y[4] + (uint128)x[1] * y[3]
+                 + (uint128)x[2] * y[2] + (uint128)x[3] * y[1]
+                 + (uint128)x[4] * y[0];
+            t[5] = (uint128)x[1] * y[4] + (uint128)x[2] * y[3]
+                 + (uint128)x[3] * y[2] + (uint128)x[4] * y[1];
+            t[6] = (uint128)x[2] * y[4] + (uint128)x[3] * y[3]
+                 + (uint128)x[4] * y[2];
+            t[7] = (uint128)x[3] * y[4] + (uint128)x[4] * y[3];
+            t[8] = (uint128)x[4] * y[4];
+
+            return reduce( t );
+        }
+
+        static
+        fe sqr( const fe &a )
+        {
+            const std::uint64_t *x = a.n;
+            std::uint64_t d0 = x[0] * 2, d1 = x[1] * 2, d2 = x[2] * 2;
+            std::uint64_t d3 = x[3] * 2;
+            uint128 t[9];
+
+            t[0] = (uint128)x[0] * x[0];
+            t[1] = (uint128)d0 * x[1];
+            t[2] = (uint128)d0 * x[2] + (uint128)x[1] * x[1];
+            t[3] = (uint128)d0 * x[3] + (uint128)d1 * x[2];
+            t[4] = (uint128)d0 * x[4] + (uint128)d1 * x[3]
+                 + (uint128)x[2] * x[2];
+            t[5] = (uint128)d1 * x[4] + (uint128)d2 * x[3];
+            t[6] = (uint128)d2 * x[4] + (uint128)x[3] * x[3];
+            t[7] = (uint128)d3 * x[4];
+            t[8] = (uint128)x[4] * x[4];
+
+            return reduce( t );
+        }
+
+        static
+        fe inv( const fe &a )
+        {
+            /// p - 2
+            static const std::uint8_t e[32] = {
+                0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                0xFF, 0xFF, 0xFF, 0xFE, 0xFF, 0xFF, 0xFC, 0x2D,
+            };
+            return pow( a, e );
+        }
+
+        /// false if 'a' is not a square
+        static
+        bool sqrt( fe &r, const fe &a )
+        {
+            /// (p + 1) / 4
+            static const std::uint8_t e[32] = {
+                0x3F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                0xFF, 0xFF, 0xFF, 0xFF, 0xBF, 0xFF, 0xFF, 0x0C,
+            };
+            r = pow( a, e );
+            return equal( sqr( r ), a );
+        }
+
+        static
+        std::uint64_t load_be64( const std::uint8_t *p )
+        {
+            std::uint64_t v = 0;
+            for( int i=0; i<8; ++i ) {
+                v = ( v << 8 ) | p[i];
+            }
+            return v;
+        }
+
+        static
+        void store_be64( std::uint8_t *p, std::uint64_t v )
+        {
+            for( int i=7; i>=0; --i ) {
+                p[i] = static_cast<std::uint8_t>(v);
+                v >>= 8;
+            }
+        }
+
+    private:
+
+        /// Folds the 9 column sums of a product back into 5 limbs. Column
+        /// k >= 5 is split at 52 bits; its low part weighs 2^260 = R52 times
+        /// column k - 5, its high part R52 times column k - 4. One carry
+        /// pass remains, ending with 2^256 = R.
+        static
+        fe reduce( uint128 *t )
+        {
+            for( int k=5; k<9; ++k ) {
+                std::uint64_t lo = static_cast<std::uint64_t>(t[k]) & M52;
+                std::uint64_t hi = static_cast<std::uint64_t>(t[k] >> 52);
+                t[k - 5] += (uint128)lo * R52;
+                t[k - 4] += (uint128)hi * R52;
+            }
+
+            fe r;
+            uint128 acc = t[0];
+            r.n[0] = static_cast<std::uint64_t>(acc) & M52; acc >>= 52;
+            acc += t[1];
+            r.n[1] = static_cast<std::uint64_t>(acc) & M52; acc >>= 52;
+            acc += t[2];
+            r.n[2] = static_cast<std::uint64_t>(acc) & M52; acc >>= 52;
+            acc += t[3];
+            r.n[3] = static_cast<std::uint64_t>(acc) & M52; acc >>= 52;
+            acc += t[4];
+            r.n[4] = static_cast<std::uint64_t>(acc) & M48; acc >>= 48;
+
+            acc = acc * R + r.n[0];
+            r.n[0] = static_cast<std::uint64_t>(acc) & M52; acc >>= 52;
+            r.n[1] += static_cast<std::uint64_t>(acc);
+            return r;
+        }
+
+        /// a^e, 'e' big endian; 4-bit fixed window
+        static
+        fe pow( const fe &a, const std::uint8_t *e )
+        {
+            fe tbl[16];
+            tbl[0] = from_int( 1 );
+            tbl[1] = a;
+            for( int i=2; i<16; ++i ) {
+                tbl[i] = mul( tbl[i - 1], a );
+            }
+
+            fe r = tbl[e[0] >> 4];
+            for( int i=1; i<64; ++i ) {
+                for( int j=0; j<4; ++j ) {
+                    r = sqr( r );
+                }
+                unsigned nib = ( i & 1 ) ? ( e[i / 2] & 0xF ) : ( e[i / 2] >> 4 );
+                if( nib ) {
+                    r = mul( r, tbl[nib] );
+                }
+            }
+            return r;
+        }
+    };
+
+    /// Integer mod the group order n as four 64-bit limbs, least
+    /// significant first. Always fully reduced.
+    struct scalar {
+
+        std::uint64_t d[4];
+
+        static
+        const std::uint64_t *order( )
+        {
+            static const std::uint64_t v[4] = {
+                0xBFD25E8CD0364141ULL, 0xBAAEDCE6AF48A03BULL,
+                0xFFFFFFFFFFFFFFFEULL, 0xFFFFFFFFFFFFFFFFULL,
+            };
+            return v;
+        }
+
+        static
+        const std::uint64_t *half_order( )
+        {
+            static const std::uint64_t v[4] = {
+                0xDFE92F46681B20A0ULL, 0x5D576E7357A4501DULL,
+                0xFFFFFFFFFFFFFFFFULL, 0x7FFFFFFFFFFFFFFFULL,
+            };
+            return v;
+        }
+
+        static
+        scalar from_int( std::uint64_t v )
+        {
+            scalar r = { { v, 0, 0, 0 } };
+            return r;
+        }
+
+        /// Reduces mod n; returns false if the value was not below n.
+        static
+        bool set_bytes( scalar &r, const std::uint8_t *b32 )
+        {
+            for( int i=0; i<4; ++i ) {
+                r.d[3 - i] = fe::load_be64( b32 + i * 8 );
+            }
+            if( !less( r.d, order( ) ) ) {
+                sub( r.d, order( ) );
+                return false;
+            }
+            return true;
+        }
+
+        void get_bytes( std::uint8_t *b32 ) const
+        {
+            for( int i=0; i<4; ++i ) {
+                fe::store_be64( b32 + i * 8, d[3 - i] );
+            }
+        }
+
+        bool is_zero( ) const
+        {
+            return ( d[0] | d[1] | d[2] | d[3] ) == 0;
+        }
+
+        /// above n / 2
+        bool is_high( ) const
+        {
+            return less( half_order( ), d );
+        }
+
+        static
+        bool equal( const scalar &a, const scalar &b )
+        {
+            return ( ( a.d[0] ^ b.d[0] ) | ( a.d[1] ^ b.d[1] )
+                   | ( a.d[2] ^ b.d[2] ) | ( a.d[3] ^ b.d[3] ) ) == 0;
+        }
+
+        static
+        scalar add( const scalar &a, const scalar &b )
+        {
+            scalar r;
+            uint128 acc = 0;
+            for( int i=0; i<4; ++i ) {
+                acc += (uint128)a.d[i] + b.d[i];
+                r.d[i] = static_cast<std::uint64_t>(acc);
+                acc >>= 64;
+            }
+            if( acc || !less( r.d, order( ) ) ) {
+                sub( r.d, order( ) );
+            }
+            return r;
+        }
+
+        static
+        scalar negate( const scalar &a )
+        {
+            if( a.is_zero( ) ) {
+                return a;
+            }
+            scalar r;
+            memcpy( r.d, order( ), sizeof(r.d) );
+            sub( r.d, a.d );
+            return r;
+        }
+
+        static
+        scalar mul( const scalar &a, const scalar &b )
+        {
+            std::uint64_t l[8];
+            mul_wide( a.d, b.d, l );
+            return reduce( l );
+        }
+
+        /// a^(n - 2), 4-bit fixed window over Montgomery products; the
+        /// exponent is public, so this runs in constant time
+        static
+        scalar inv( const scalar &a )
+        {
+            static const std::uint8_t e[32] = {
+                0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE,
+                0xBA, 0xAE, 0xDC, 0xE6, 0xAF, 0x48, 0xA0, 0x3B,
+                0xBF, 0xD2, 0x5E, 0x8C, 0xD0, 0x36, 0x41, 0x3F,
+            };
+            /// 2^512 mod n
+            static const scalar r2 = { {
+                0x896CF21467D7D140ULL, 0x741496C20E7CF878ULL,
+                0xE697F5E45BCD07C6ULL, 0x9D671CD581C69BC5ULL,
+            } };
+
+            scalar tbl[16];
+            tbl[1] = mont_mul( a, r2 );
+            tbl[0] = mont_mul( from_int( 1 ), r2 );
+            for( int i=2; i<16; ++i ) {
+                tbl[i] = mont_mul( tbl[i - 1], tbl[1] );
+            }
+            scalar r = tbl[e[0] >> 4];
+            for( int i=1; i<64; ++i ) {
+                for( int j=0; j<4; ++j ) {
+                    r = mont_mul( r, r );
+                }
+                unsigned nib = ( i & 1 ) ? ( e[i / 2] & 0xF ) : ( e[i / 2] >> 4 );
+                if( nib ) {
+                    r = mont_mul( r, tbl[nib] );
+                }
+            }
+            return mont_mul( r, from_int( 1 ) );
+        }
+
+        /// round(a * b / 2^384); used by the GLV split
+        static
+        scalar mul_shift_384( const scalar &a, const scalar &b )
+        {
+            std::uint64_t l[8];
+            mul_wide( a.d, b.d, l );
+            scalar r = { { l[6], l[7], 0, 0 } };
+            std::uint64_t round = l[5] >> 63;
+            r.d[0] += round;
+            r.d[1] += ( r.d[0] < round );
+            return r;
+        }
+
+        /// Splits k into k1 + k2 * lambda (mod n) with k1 and k2 (or their
+        /// negations) below 2^128.
+        static
+        void split_lambda( const scalar &k, scalar &k1, scalar &k2 )
+        {
+            static const scalar g1 = { {
+                0xE893209A45DBB031ULL, 0x3DAA8A1471E8CA7FULL,
+                0xE86C90E49284EB15ULL, 0x3086D221A7D46BCDULL,
+            } };
+            static const scalar g2 = { {
+                0x1571B4AE8AC47F71ULL, 0x221208AC9DF506C6ULL,
+                0x6F547FA90ABFE4C4ULL, 0xE4437ED6010E8828ULL,
+            } };
+            static const scalar minus_b1 = { {
+                0x6F547FA90ABFE4C3ULL, 0xE4437ED6010E8828ULL, 0, 0,
+            } };
+            static const scalar minus_b2 = { {
+                0xD765CDA83DB1562CULL, 0x8A280AC50774346DULL,
+                0xFFFFFFFFFFFFFFFEULL, 0xFFFFFFFFFFFFFFFFULL,
+            } };
+
+            scalar c1 = mul( mul_shift_384( k, g1 ), minus_b1 );
+            scalar c2 = mul( mul_shift_384( k, g2 ), minus_b2 );
+            k2 = add( c1, c2 );
+            k1 = add( k, negate( mul( k2, lambda( ) ) ) );
+        }
+
+        static
+        const scalar &lambda( )
+        {
+            static const scalar v = { {
+                0xDF02967C1B23BD72ULL, 0x122E22EA20816678ULL,
+                0xA5261C028812645AULL, 0x5363AD4CC05C30E0ULL,
+            } };
+            return v;
+        }
+
+    private:
+
+        static
+        bool less( const std::uint64_t *a, const std::uint64_t *b )
+        {
+            for( int i=3; i>=0; --i ) {
+                if( a[i] != b[i] ) {
+                    return a[i] < b[i];
+                }
+            }
+            return false;
+        }
+
+        static
+        void sub( std::uint64_t *a, const std::uint64_t *b )
+        {
+            std::uint64_t borrow = 0;
+            for( int i=0; i<4; ++i ) {
+                uint128 t = (uint128)a[i] - b[i] - borrow;
+                a[i] = static_cast<std::uint64_t>(t);
+                borrow = static_cast<std::uint64_t>(t >> 64) & 1;
+            }
+        }
+
+        /// a * b / 2^256 mod n (CIOS)
+        static
+        scalar mont_mul( const scalar &a, const scalar &b )
+        {
+            static const std::uint64_t ninv = 0x4B0DFF665588B13FULL;
+            const std::uint64_t *n = order( );
+            std::uint64_t t[6] = { 0 };
+
+            for( int i=0; i<4; ++i ) {
+                std::uint64_t c = 0;
+                for( int j=0; j<4; ++j ) {
+                    uint128 v = (uint128)a.d[j] * b.d[i] + t[j] + c;
+                    t[j] = static_cast<std::uint64_t>(v);
+                    c    = static_cast<std::uint64_t>(v >> 64);
+                }
+                uint128 v = (uint128)t[4] + c;
+                t[4] = static_cast<std::uint64_t>(v);
+                t[5] = static_cast<std::uint64_t>(v >> 64);
+
+                std::uint64_t m = t[0] * ninv;
+                v = (uint128)m * n[0] + t[0];
+                c = static_cast<std::uint64_t>(v >> 64);
+                for( int j=1; j<4; ++j ) {
+                    v = (uint128)m * n[j] + t[j] + c;
+                    t[j - 1] = static_cast<std::uint64_t>(v);
+                    c        = static_cast<std::uint64_t>(v >> 64);
+                }
+                v = (uint128)t[4] + c;
+                t[3] = static_cast<std::uint64_t>(v);
+                t[4] = t[5] + static_cast<std::uint64_t>(v >> 64);
+            }
+
+            scalar r = { { t[0], t[1], t[2], t[3] } };
+            if( t[4] || !less( r.d, n ) ) {
+                sub( r.d, n );
+            }
+            return r;
+        }
+
+        static
+        void mul_wide( const std::uint64_t *a, const std::uint64_t *b,
+                       std::uint64_t *l )
+        {
+            memset( l, 0, sizeof(std::uint64_t) * 8 );
+            for( int i=0; i<4; ++i ) {
+                std::uint64_t carry = 0;
+                for( int j=0; j<4; ++j ) {
+                    uint128 t = (uint128)a[i] * b[j] + l[i + j] + carry;
+                    l[i + j] = static_cast<std::uint64_t>(t);
+                    carry = static_cast<std::uint64_t>(t >> 64);
+                }
+                l[i + 4] = carry;
+            }
+        }
+
+        /// out = lo[0..4) + hi[0..HN) * (2^256 - n); 'out' holds HN + 4
+        /// limbs
+        template <int HN>
+        static
+        void fold( const std::uint64_t *lo, const std::uint64_t *hi,
+                   std::uint64_t *out )
+        {
+            static const std::uint64_t nc0 = 0x402DA1732FC9BEBFULL;
+            static const std::uint64_t nc1 = 0x4551231950B75FC4ULL;
+
+            /// column sums of 64-bit halves; the high half of a product
+            /// goes straight to the next column. nc2 == 1, so hi[i] is
+            /// added as is two columns up.
+            uint128 carry = 0;
+            for( int k=0; k<HN + 4; ++k ) {
+                uint128 col  = carry;
+                uint128 next = 0;
+                if( k < 4 ) {
+                    col += lo[k];
+                }
+                if( k < HN ) {
+                    uint128 t = (uint128)hi[k] * nc0;
+                    col  += static_cast<std::uint64_t>(t);
+                    next += static_cast<std::uint64_t>(t >> 64);
+                }
+                if( k >= 1 && k - 1 < HN ) {
+                    uint128 t = (uint128)hi[k - 1] * nc1;
+                    col  += static_cast<std::uint64_t>(t);
+                    next += static_cast<std::uint64_t>(t >> 64);
+                }
+                if( k >= 2 && k - 2 < HN ) {
+                    col += hi[k - 2];
+                }
+                out[k] = static_cast<std::uint64_t>(col);
+                carry  = ( col >> 64 ) + next;
+            }
+        }
+
+        static
+        scalar reduce( const std::uint64_t *l )
+        {
+            std::uint64_t m[8];
+            std::uint64_t p[7];
+            std::uint64_t q[5];
+
+            fold<4>( l, l + 4, m );   /// < 2^386
+            fold<3>( m, m + 4, p );   /// < 2^260
+            fold<1>( p, p + 4, q );   /// < 2^257
+
+            scalar r = { { q[0], q[1], q[2], q[3] } };
+            if( q[4] ) {
+                /// drop 2^256, add it back as 2^256 - n
+                static const std::uint64_t nc[4] = {
+                    0x402DA1732FC9BEBFULL, 0x4551231950B75FC4ULL, 1, 0,
+                };
+                uint128 acc = 0;
+                for( int i=0; i<4; ++i ) {
+                    acc += (uint128)r.d[i] + nc[i];
+                    r.d[i] = static_cast<std::uint64_t>(acc);
+                    acc >>= 64;
+                }
+            }
+            if( !less( r.d, order( ) ) ) {
+                sub( r.d, order( ) );
+            }
+            return r;
+        }
+    };
+
+    /// Affine point.
+    struct ge {
+
+        fe   x;
+        fe   y;
+        bool infinity;
+
+        static
+        const ge &generator( )
+        {
+            static const ge g = make( {
+                0x79, 0xBE, 0x66, 0x7E, 0xF9, 0xDC, 0xBB, 0xAC,
+                0x55, 0xA0, 0x62, 0x95, 0xCE, 0x87, 0x0B, 0x07,
+                0x02, 0x9B, 0xFC, 0xDB, 0x2D, 0xCE, 0x28, 0xD9,
+                0x59, 0xF2, 0x81, 0x5B, 0x16, 0xF8, 0x17, 0x98,
+            }, {
+                0x48, 0x3A, 0xDA, 0x77, 0x26, 0xA3, 0xC4, 0x65,
+                0x5D, 0xA4, 0xFB, 0xFC, 0x0E, 0x11, 0x08, 0xA8,
+                0xFD, 0x17, 0xB4, 0x48, 0xA6, 0x85, 0x54, 0x19,
+                0x9C, 0x47, 0xD0, 0x8F, 0xFB, 0x10, 0xD4, 0xB8,
+            } );
+            return g;
+        }
+
+        /// beta, the cube root of unity with lambda * (x, y) = (beta x, y)
+        static
+        const fe &beta( )
+        {
+            static const fe b = make_fe( {
+                0x7A, 0xE9, 0x6A, 0x2B, 0x65, 0x7C, 0x07, 0x10,
+                0x6E, 0x64, 0x47, 0x9E, 0xAC, 0x34, 0x34, 0xE9,
+                0x9C, 0xF0, 0x49, 0x75, 0x12, 0xF5, 0x89, 0x95,
+                0xC1, 0x39, 0x6C, 0x28, 0x71, 0x95, 0x01, 0xEE,
+            } );
+            return b;
+        }
+
+        bool on_curve( ) const
+        {
+            if( infinity ) {
+                return false;
+            }
+            fe rhs = fe::mul( fe::sqr( x ), x );
+            rhs.add( fe::from_int( 7 ) );
+            return fe::equal( fe::sqr( y ), rhs );
+        }
+
+        ge neg( ) const
+        {
+            ge r = *this;
+            r.y.normalize_weak( );
+            r.y = fe::negate( r.y, 1 );
+            r.y.normalize_weak( );
+            return r;
+        }
+
+        /// Point with the given x and y parity, if there is one.
+        static
+        bool set_x( ge &r, const fe &x, bool odd )
+        {
+            fe rhs = fe::mul( fe::sqr( x ), x );
+            rhs.add( fe::from_int( 7 ) );
+            if( !fe::sqrt( r.y, rhs ) ) {
+                return false;
+            }
+            r.x = x;
+            r.x.normalize( );
+            r.y.normalize( );
+            if( r.y.is_odd( ) != odd ) {
+                r.y = fe::negate( r.y, 1 );
+                r.y.normalize( );
+            }
+            r.infinity = false;
+            return true;
+        }
+
+        /// SEC1 compressed (33 bytes) or uncompressed (65 bytes)
+        static
+        bool parse( ge &r, const std::uint8_t *data, std::size_t len )
+        {
+            fe x;
+            if( len == 33 && ( data[0] == 2 || data[0] == 3 ) ) {
+                return fe::set_bytes( x, data + 1 )
+                    && set_x( r, x, data[0] == 3 );
+            }
+            if( len == 65 && data[0] == 4 ) {
+                if( !fe::set_bytes( r.x, data + 1 ) ||
+                    !fe::set_bytes( r.y, data + 33 ) )
+                {
+                    return false;
+                }
+                r.infinity = false;
+                return r.on_curve( );
+            }
+            return false;
+        }
+
+        /// returns the length written, 33 or 65
+        std::size_t serialize( std::uint8_t *out, bool compressed ) const
+        {
+            fe nx = x, ny = y;
+            nx.normalize( );
+            ny.normalize( );
+            nx.get_bytes( out + 1 );
+            if( compressed ) {
+                out[0] = ny.is_odd( ) ? 3 : 2;
+                return 33;
+            }
+            out[0] = 4;
+            ny.get_bytes( out + 33 );
+            return 65;
+        }
+
+    private:
+
+        static
+        fe make_fe( std::initializer_list<std::uint8_t> b )
+        {
+            fe r;
+            fe::set_bytes( r, b.begin( ) );
+            return r;
+        }
+
+        static
+        ge make( std::initializer_list<std::uint8_t> x,
+                 std::initializer_list<std::uint8_t> y )
+        {
+            ge r;
+            r.x = make_fe( x );
+            r.y = make_fe( y );
+            r.infinity = false;
+            return r;
+        }
+    };
+
+    /// Jacobian point: (X / Z^2, Y / Z^3). Coordinates are kept at
+    /// magnitude 1 between operations.
+    struct gej {
+
+        fe   x;
+        fe   y;
+        fe   z;
+        bool infinity;
+
+        static
+        gej inf( )
+        {
+            gej r;
+            r.x = r.y = r.z = fe::from_int( 0 );
+            r.infinity = true;
+            return r;
+        }
+
+        static
+        gej from_ge( const ge &a )
+        {
+            gej r;
+            r.x = a.x;
+            r.y = a.y;
+            r.z = fe::from_int( 1 );
+            r.infinity = a.infinity;
+            return r;
+        }
+
+        gej neg( ) const
+        {
+            gej r = *this;
+            r.y = fe::negate( y, 1 );
+            r.y.normalize_weak( );
+            return r;
+        }
+
+        /// dbl-2009-l for a = 0
+        static
+        gej dbl( const gej &a )
+        {
+            if( a.infinity ) {
+                return a;
+            }
+            gej r;
+            r.infinity = false;
+
+            r.z = fe::mul( a.y, a.z );
+            r.z.mul_int( 2 );                            /// 2
+            r.z.normalize_weak( );
+
+            fe A = fe::sqr( a.x );
+            fe B = fe::sqr( a.y );
+            fe C = fe::sqr( B );
+
+            fe D = a.x;
+            D.add( B );                                  /// 2
+            D = fe::sqr( D );
+            D.add( fe::negate( A, 1 ) );
+            D.add( fe::negate( C, 1 ) );                 /// 5
+            D.mul_int( 2 );                              /// 10
+            D.normalize_weak( );
+
+            fe E = A;
+            E.mul_int( 3 );                              /// 3
+            fe F = fe::sqr( E );
+
+            fe D2 = D;
+            D2.mul_int( 2 );                             /// 2
+            r.x = F;
+            r.x.add( fe::negate( D2, 2 ) );              /// 4
+            r.x.normalize_weak( );
+
+            fe t = D;
+            t.add( fe::negate( r.x, 1 ) );               /// 3
+            r.y = fe::mul( E, t );
+            C.mul_int( 8 );                              /// 8
+            r.y.add( fe::negate( C, 8 ) );               /// 10
+            r.y.normalize_weak( );
+            return r;
+        }
+
+        /// a + b with b affine
+        static
+        gej add_ge( const gej &a, const ge &b )
+        {
+            if( a.infinity ) {
+                return from_ge( b );
+            }
+            if( b.infinity ) {
+                return a;
+            }
+
+            fe z2 = fe::sqr( a.z );
+            fe u2 = fe::mul( b.x, z2 );
+            fe s2 = fe::mul( b.y, fe::mul( a.z, z2 ) );
+
+            fe h = u2;
+            h.add( fe::negate( a.x, 1 ) );               /// 3
+            fe rr = s2;
+            rr.add( fe::negate( a.y, 1 ) );              /// 3
+
+            if( h.normalizes_to_zero( ) ) {
+                if( rr.normalizes_to_zero( ) ) {
+                    return dbl( a );
+                }
+                return inf( );
+            }
+            return finish_add( a.x, a.y, a.z, h, rr );
+        }
+
+        static
+        gej add( const gej &a, const gej &b )
+        {
+            if( a.infinity ) {
+                return b;
+            }
+            if( b.infinity ) {
+                return a;
+            }
+
+            fe z1 = fe::sqr( a.z );
+            fe z2 = fe::sqr( b.z );
+            fe u1 = fe::mul( a.x, z2 );
+            fe u2 = fe::mul( b.x, z1 );
+            fe s1 = fe::mul( a.y, fe::mul( b.z, z2 ) );
+            fe s2 = fe::mul( b.y, fe::mul( a.z, z1 ) );
+
+            fe h = u2;
+            h.add( fe::negate( u1, 1 ) );
+            fe rr = s2;
+            rr.add( fe::negate( s1, 1 ) );
+
+            if( h.normalizes_to_zero( ) ) {
+                if( rr.normalizes_to_zero( ) ) {
+                    return dbl( a );
+                }
+                return inf( );
+            }
+            return finish_add( u1, s1, fe::mul( a.z, b.z ), h, rr );
+        }
+
+        /// x / z^2 compared against a field element
+        bool x_equals( const fe &v ) const
+        {
+            return !infinity && fe::equal( fe::mul( v, fe::sqr( z ) ), x );
+        }
+
+    private:
+
+        /// shared tail of the additions: u1 = X1 (scaled), s1 = Y1
+        /// (scaled), zz = Z1 (* Z2), h = U2 - U1, r = S2 - S1
+        static
+        gej finish_add( const fe &u1, const fe &s1, const fe &zz,
+                        const fe &h, const fe &rr )
+        {
+            gej r;
+            r.infinity = false;
+
+            fe hh  = fe::sqr( h );
+            fe hhh = fe::mul( h, hh );
+            fe v   = fe::mul( u1, hh );
+
+            r.z = fe::mul( zz, h );
+
+            fe v2 = v;
+            v2.mul_int( 2 );                             /// 2
+            r.x = fe::sqr( rr );
+            r.x.add( fe::negate( hhh, 1 ) );
+            r.x.add( fe::negate( v2, 2 ) );              /// 6
+            r.x.normalize_weak( );
+
+            fe t = v;
+            t.add( fe::negate( r.x, 1 ) );               /// 3
+            r.y = fe::mul( rr, t );
+            r.y.add( fe::negate( fe::mul( s1, hhh ), 1 ) );
+            r.y.normalize_weak( );
+            return r;
+        }
+    };
+
+    struct points {
+
+        /// Converts 'count' Jacobian points to affine with one field
+        /// inversion (Montgomery's trick).
+        static
+        void to_affine( const gej *src, std::size_t count, ge *dst )
+        {
+            std::vector<fe> acc(count);
+            fe run = fe::from_int( 1 );
+            for( std::size_t i=0; i<count; ++i ) {
+                acc[i] = run;
+                if( !src[i].infinity ) {
+                    run = fe::mul( run, src[i].z );
+                }
+            }
+            fe inv = fe::inv( run );
+            for( std::size_t i=count; i-- > 0; ) {
+                if( src[i].infinity ) {
+                    dst[i].infinity = true;
+                    continue;
+                }
+                fe zi  = fe::mul( inv, acc[i] );
+                inv    = fe::mul( inv, src[i].z );
+                fe zi2 = fe::sqr( zi );
+                dst[i].x = fe::mul( src[i].x, zi2 );
+                dst[i].y = fe::mul( src[i].y, fe::mul( zi, zi2 ) );
+                dst[i].x.normalize( );
+                dst[i].y.normalize( );
+                dst[i].infinity = false;
+            }
+        }
+
+        static
+        ge to_affine( const gej &a )
+        {
+            ge r;
+            to_affine( &a, 1, &r );
+            return r;
+        }
+    };
+
+    /// Scalar multiplication.
+    ///
+    /// gen( ) computes k * G from a table of 64 x 16 affine points
+    /// T[i][j] = j * 16^i * G + U[i], where the U[i] are multiples of a
+    /// point with unknown discrete log summing to zero. Each 4-bit window
+    /// of k picks its entry by scanning the whole row, and no addition
+    /// meets the identity, so the secret only affects data, not branches
+    /// or addresses (barring negligible-probability special cases).
+    ///
+    /// mul( ) computes ng * G + nq * Q for verification, in variable time:
+    /// both scalars are split with the GLV endomorphism into ~128-bit
+    /// halves and walked as wNAF over shared doublings, G from a window-10
+    /// affine table, Q from a window-5 table built per call.
+    class ecmult {
+
+    public:
+
+        enum { gen_windows = 64, gen_teeth = 16 };
+        enum { g_window = 10, q_window = 5 };
+        enum { g_table = 1 << ( g_window - 2 ), q_table = 1 << ( q_window - 2 ) };
+
+        static
+        gej gen( const scalar &k )
+        {
+            const auto &tbl = tables::get( );
+            gej r = gej::inf( );
+            for( int i=0; i<gen_windows; ++i ) {
+                unsigned nib = static_cast<unsigned>(
+                            k.d[i / 16] >> ( ( i % 16 ) * 4 ) ) & 0xF;
+                ge e;
+                select( e, tbl.comb[i], nib );
+                r = gej::add_ge( r, e );
+            }
+            return r;
+        }
+
+        static
+        gej mul( const scalar &ng, const ge &q, const scalar &nq )
+        {
+            const auto &tbl = tables::get( );
+
+            scalar g1, g2, q1, q2;
+            scalar::split_lambda( ng, g1, g2 );
+            scalar::split_lambda( nq, q1, q2 );
+
+            bool neg_g1 = make_small( g1 );
+            bool neg_g2 = make_small( g2 );
+            bool neg_q1 = make_small( q1 );
+            bool neg_q2 = make_small( q2 );
+
+            int wg1[wnaf_max], wg2[wnaf_max], wq1[wnaf_max], wq2[wnaf_max];
+            int bits = 0;
+            bits = max_of( bits, wnaf( wg1, g1, g_window ) );
+            bits = max_of( bits, wnaf( wg2, g2, g_window ) );
+            bits = max_of( bits, wnaf( wq1, q1, q_window ) );
+            bits = max_of( bits, wnaf( wq2, q2, q_window ) );
+
+            /// odd multiples of Q and lambda * Q
+            gej qt[q_table];
+            gej ql[q_table];
+            qt[0] = gej::from_ge( q );
+            gej q2x = gej::dbl( qt[0] );
+            for( int i=1; i<q_table; ++i ) {
+                qt[i] = gej::add( qt[i - 1], q2x );
+            }
+            for( int i=0; i<q_table; ++i ) {
+                ql[i] = qt[i];
+                ql[i].x = fe::mul( qt[i].x, ge::beta( ) );
+            }
+
+            gej r = gej::inf( );
+            for( int i=bits - 1; i>=0; --i ) {
+                r = gej::dbl( r );
+                add_jac( r, qt, wq1[i], neg_q1 );
+                add_jac( r, ql, wq2[i], neg_q2 );
+                add_aff( r, tbl.g,      wg1[i], neg_g1 );
+                add_aff( r, tbl.lambda, wg2[i], neg_g2 );
+            }
+            return r;
+        }
+
+    private:
+
+        enum { wnaf_max = 132 };
+
+        struct tables {
+
+            ge comb[gen_windows][gen_teeth];
+            ge g[g_table];      /// G, 3G, 5G, ...
+            ge lambda[g_table]; /// lambda * the above
+
+            static
+            const tables &get( )
+            {
+                static const tables inst;
+                return inst;
+            }
+
+            tables( )
+            {
+                build_comb( );
+                build_odd( );
+            }
+
+            void build_comb( )
+            {
+                std::vector<gej> tmp(gen_windows * gen_teeth);
+
+                gej base = gej::from_ge( ge::generator( ) );
+                gej u    = gej::from_ge( nums( ) );
+                gej sum  = gej::inf( );
+
+                for( int i=0; i<gen_windows; ++i ) {
+                    gej e;
+                    if( i + 1 < gen_windows ) {
+                        e   = u;
+                        sum = gej::add( sum, u );
+                        u   = gej::dbl( u );
+                    } else {
+                        e = sum.neg( );
+                    }
+                    for( int j=0; j<gen_teeth; ++j ) {
+                        tmp[i * gen_teeth + j] = e;
+                        e = gej::add( e, base );
+                    }
+                    for( int j=0; j<4; ++j ) {
+                        base = gej::dbl( base );
+                    }
+                }
+                points::to_affine( tmp.data( ), tmp.size( ), &comb[0][0] );
+            }
+
+            void build_odd( )
+            {
+                std::vector<gej> tmp(g_table);
+                tmp[0] = gej::from_ge( ge::generator( ) );
+                gej g2 = gej::dbl( tmp[0] );
+                for( int i=1; i<g_table; ++i ) {
+                    tmp[i] = gej::add( tmp[i - 1], g2 );
+                }
+                points::to_affine( tmp.data( ), tmp.size( ), g );
+                for( int i=0; i<g_table; ++i ) {
+                    lambda[i] = g[i];
+                    lambda[i].x = fe::mul( g[i].x, ge::beta( ) );
+                    lambda[i].x.normalize( );
+                }
+            }
+
+            /// first valid x counting up from SHA256 of a fixed label
+            static
+            ge nums( )
+            {
+                static const char label[] = "bitchain secp256k1 nums point";
+                std::uint8_t h[32];
+                SHA256( reinterpret_cast<const std::uint8_t *>(label),
+                        sizeof(label) - 1, h );
+                fe x;
+                fe::set_bytes( x, h );
+                ge r;
+                while( !ge::set_x( r, x, false ) ) {
+                    x.add( fe::from_int( 1 ) );
+                    x.normalize( );
+                }
+                return r;
+            }
+        };
+
+        static
+        int max_of( int a, int b )
+        {
+            return a < b ? b : a;
+        }
+
+        static
+        void select( ge &r, const ge *row, unsigned idx )
+        {
+            memset( &r, 0, sizeof(r) );
+            for( unsigned j=0; j<gen_teeth; ++j ) {
+                std::uint64_t mask = 0 - static_cast<std::uint64_t>(j == idx);
+                for( int l=0; l<5; ++l ) {
+                    r.x.n[l] |= row[j].x.n[l] & mask;
+                    r.y.n[l] |= row[j].y.n[l] & mask;
+                }
+            }
+            r.infinity = false;
+        }
+
+        /// Replaces a "high" half by its negation; returns true if it did.
+        static
+        bool make_small( scalar &s )
+        {
+            if( s.is_high( ) ) {
+                s = scalar::negate( s );
+                return true;
+            }
+            return false;
+        }
+
+        /// Width-w NAF of a scalar below 2^129; returns the digit count.
+        static
+        int wnaf( int *out, const scalar &s, int w )
+        {
+            std::uint64_t k[3] = { s.d[0], s.d[1], s.d[2] };
+            const std::uint64_t mask = ( 1ULL << w ) - 1;
+            int pos = 0;
+            int last = 0;
+
+            memset( out, 0, sizeof(int) * wnaf_max );
+            while( k[0] | k[1] | k[2] ) {
+                if( k[0] & 1 ) {
+                    int digit = static_cast<int>(k[0] & mask);
+                    if( digit >= ( 1 << ( w - 1 ) ) ) {
+                        digit -= ( 1 << w );
+                    }
+                    out[pos] = digit;
+                    last = pos + 1;
+                    if( digit > 0 ) {
+                        std::uint64_t v = static_cast<std::uint64_t>(digit);
+                        std::uint64_t b = k[0] < v;
+                        k[0] -= v;
+                        k[1] -= b; b = b && k[1] == ~0ULL;
+                        k[2] -= b;
+                    } else {
+                        std::uint64_t v = static_cast<std::uint64_t>(-digit);
+                        k[0] += v;
+                        std::uint64_t c = k[0] < v;
+                        k[1] += c; c = c && k[1] == 0;
+                        k[2] += c;
+                    }
+                }
+                k[0] = ( k[0] >> 1 ) | ( k[1] << 63 );
+                k[1] = ( k[1] >> 1 ) | ( k[2] << 63 );
+                k[2] >>= 1;
+                ++pos;
+            }
+            return last;
+        }
+
+        static
+        void add_aff( gej &r, const ge *tbl, int digit, bool negate )
+        {
+            if( digit == 0 ) {
+                return;
+            }
+            bool neg = ( digit < 0 ) != negate;
+            const ge &p = tbl[( digit < 0 ? -digit : digit ) / 2];
+            r = gej::add_ge( r, neg ? p.neg( ) : p );
+        }
+
+        static
+        void add_jac( gej &r, const gej *tbl, int digit, bool negate )
+        {
+            if( digit == 0 ) {
+                return;
+            }
+            bool neg = ( digit < 0 ) != negate;
+            const gej &p = tbl[( digit < 0 ? -digit : digit ) / 2];
+            r = gej::add( r, neg ? p.neg( ) : p );
+        }
+    };
+
+    /// ECDSA over the native arithmetic. Digests are taken as 32-byte big
+    /// endian integers reduced mod n.
+    struct ecdsa {
+
+        static
+        scalar digest_scalar( const std::uint8_t *digest, std::size_t len )
+        {
+            std::uint8_t buf[32] = { 0 };
+            if( len > 32 ) {
+                len = 32;
+            }
+            memcpy( buf + 32 - len, digest, len );
+            scalar r;
+            scalar::set_bytes( r, buf );
+            return r;
+        }
+
+        static
+        ge public_key( const scalar &priv )
+        {
+            return points::to_affine( ecmult::gen( priv ) );
+        }
+
+        /// false if 'nonce' yields r == 0 or s == 0; pick another one
+        static
+        bool sign( scalar &r, scalar &s, const scalar &priv,
+                   const scalar &msg, const scalar &nonce )
+        {
+            if( nonce.is_zero( ) || priv.is_zero( ) ) {
+                return false;
+            }
+            ge R = points::to_affine( ecmult::gen( nonce ) );
+            std::uint8_t xb[32];
+            R.x.get_bytes( xb );
+            scalar::set_bytes( r, xb );
+            if( r.is_zero( ) ) {
+                return false;
+            }
+            s = scalar::mul( scalar::inv( nonce ),
+                             scalar::add( msg, scalar::mul( r, priv ) ) );
+            return !s.is_zero( );
+        }
+
+        static
+        bool verify( const scalar &r, const scalar &s, const ge &pub,
+                     const scalar &msg )
+        {
+            if( r.is_zero( ) || s.is_zero( ) || pub.infinity ) {
+                return false;
+            }
+            scalar w  = scalar::inv( s );
+            scalar u1 = scalar::mul( msg, w );
+            scalar u2 = scalar::mul( r, w );
+
+            gej R = ecmult::mul( u1, pub, u2 );
+            if( R.infinity ) {
+                return false;
+            }
+
+            /// R.x mod n == r, without the inversion: r or r + n (if
+            /// still below p) times Z^2 must equal X
+            std::uint8_t rb[32];
+            r.get_bytes( rb );
+            fe xr;
+            fe::set_bytes( xr, rb );
+            if( R.x_equals( xr ) ) {
+                return true;
+            }
+
+            static const scalar p_minus_n = { {
+                0x402DA1722FC9BAEEULL, 0x4551231950B75FC4ULL, 1, 0,
+            } };
+            bool below = false;
+            for( int i=3; i>=0; --i ) {
+                if( r.d[i] != p_minus_n.d[i] ) {
+                    below = r.d[i] < p_minus_n.d[i];
+                    break;
+                }
+            }
+            if( !below ) {
+                return false;
+            }
+            static const fe n_fe = { {
+                0x25E8CD0364141ULL, 0xE6AF48A03BBFDULL, 0xFFFFFFEBAAEDCULL,
+                0xFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFULL,
+            } };
+            xr.add( n_fe );
+            return R.x_equals( xr );
+        }
+    };
+
+}}
+
+#endif // SECP256K1_H
@@ -0,0 +1,694 @@
+#ifndef SHA256_ENGINE_H
+#define SHA256_ENGINE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <memory.h>
+
+#include "etool/slices/memory.h"
+
+#if !defined(BITCHAIN_SHA256_NO_SIMD) \
+  && ( defined(__GNUC__) || defined(__clang__) ) \
+  && ( defined(__x86_64__) || defined(__i386__) )
+#   define BITCHAIN_SHA256_X86 1
+#   include <cpuid.h>
+#   include <immintrin.h>
+#endif
+
+namespace bchain { namespace hash {
+
+    /// Raw SHA-256 compression functions with runtime CPU dispatch.
+    /// sha256::get_many and friends (hash.h) are built on top of this;
+    /// the single-message path stays on OpenSSL.
+    struct sha256_engine {
+
+        using slice = etool::slices::memory<const std::uint8_t>;
+
+        enum { block_length  = 64 };
+        enum { digest_length = 32 };
+
+        static
+        const std::uint32_t *initial_state( )
+        {
+            static const std::uint32_t iv[8] = {
+                0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+            };
+            return iv;
+        }
+
+        static
+        const std::uint32_t *round_constants( )
+        {
+            static const std::uint32_t k[64] = {
+                0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+                0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+                0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+                0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+                0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+                0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+                0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+                0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+                0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+                0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+                0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+                0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+                0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+                0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+                0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+                0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+            };
+            return k;
+        }
+
+        static
+        std::uint32_t read_be32( const std::uint8_t *p )
+        {
+            return ( static_cast<std::uint32_t>(p[0]) << 24 )
+                 | ( static_cast<std::uint32_t>(p[1]) << 16 )
+                 | ( static_cast<std::uint32_t>(p[2]) <<  8 )
+                 | ( static_cast<std::uint32_t>(p[3])       );
+        }
+
+        static
+        void write_be32( std::uint32_t val, std::uint8_t *p )
+        {
+            p[0] = static_cast<std::uint8_t>(val >> 24);
+            p[1] = static_cast<std::uint8_t>(val >> 16);
+            p[2] = static_cast<std::uint8_t>(val >>  8);
+            p[3] = static_cast<std::uint8_t>(val      );
+        }
+
+        static
+        void write_be64( std::uint64_t val, std::uint8_t *p )
+        {
+            write_be32( static_cast<std::uint32_t>(val >> 32), p     );
+            write_be32( static_cast<std::uint32_t>(val      ), p + 4 );
+        }
+
+        static
+        void store_digest( const std::uint32_t state[8], std::uint8_t *dst )
+        {
+            for( int i=0; i<8; ++i ) {
+                write_be32( state[i], dst + i * 4 );
+            }
+        }
+
+        /// A message split into its 64-byte blocks with the SHA-256 padding
+        /// materialised in a small tail buffer. The message bytes are not
+        /// copied.
+        struct padded_message {
+
+            const std::uint8_t *data   = nullptr;
+            std::size_t         full   = 0;
+            std::size_t         blocks = 0;
+            std::uint8_t        tail[block_length * 2];
+
+            padded_message( ) = default;
+
+            padded_message( const std::uint8_t *d, std::size_t len )
+            {
+                assign( d, len );
+            }
+
+            void assign( const std::uint8_t *d, std::size_t len )
+            {
+                data = d;
+                full = len / block_length;
+
+                std::size_t rest = len % block_length;
+                std::size_t tail_blocks = ( rest + 9 <= block_length ) ? 1 : 2;
+                std::size_t tail_len    = tail_blocks * block_length;
+
+                memset( tail, 0, tail_len );
+                if( rest ) {
+                    memcpy( tail, d + full * block_length, rest );
+                }
+                tail[rest] = 0x80;
+                write_be64( static_cast<std::uint64_t>(len) * 8,
+                            &tail[tail_len - 8] );
+                blocks = full + tail_blocks;
+            }
+
+            const std::uint8_t *block( std::size_t id ) const
+            {
+                return ( id < full )
+                     ? data + id * block_length
+                     : tail + ( id - full ) * block_length;
+            }
+        };
+
+        static
+        std::uint32_t rotr( std::uint32_t x, int n )
+        {
+            return ( x >> n ) | ( x << ( 32 - n ) );
+        }
+
+        /// Portable single-stream path, used when SHA-NI is missing.
+        static
+        void transform_scalar( std::uint32_t state[8],
+                               const std::uint8_t *blocks, std::size_t count )
+        {
+            const std::uint32_t *k = round_constants( );
+
+            for( ; count > 0; --count, blocks += block_length ) {
+                std::uint32_t w[64];
+                for( int t=0; t<16; ++t ) {
+                    w[t] = read_be32( blocks + t * 4 );
+                }
+                for( int t=16; t<64; ++t ) {
+                    std::uint32_t s0 = rotr( w[t - 15], 7 )
+                                     ^ rotr( w[t - 15], 18 )
+                                     ^ ( w[t - 15] >> 3 );
+                    std::uint32_t s1 = rotr( w[t - 2], 17 )
+                                     ^ rotr( w[t - 2], 19 )
+                                     ^ ( w[t - 2] >> 10 );
+                    w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+                }
+
+                std::uint32_t a = state[0], b = state[1];
+                std::uint32_t c = state[2], d = state[3];
+                std::uint32_t e = state[4], f = state[5];
+                std::uint32_t g = state[6], h = state[7];
+
+                for( int t=0; t<64; ++t ) {
+                    std::uint32_t t1 = h
+                                     + ( rotr( e, 6 ) ^ rotr( e, 11 )
+                                                      ^ rotr( e, 25 ) )
+                                     + ( ( e & f ) ^ ( ~e & g ) )
+                                     + k[t] + w[t];
+                    std::uint32_t t2 = ( rotr( a, 2 ) ^ rotr( a, 13 )
+                                                      ^ rotr( a, 22 ) )
+                                     + ( ( a & b ) ^ ( a & c ) ^ ( b & c ) );
+                    h = g;
+                    g = f;
+                    f = e;
+                    e = d + t1;
+                    d = c;
+                    c = b;
+                    b = a;
+                    a = t1 + t2;
+                }
+
+                state[0] += a; state[1] += b;
+                state[2] += c; state[3] += d;
+                state[4] += e; state[5] += f;
+                state[6] += g; state[7] += h;
+            }
+        }
+
+        struct cpu {
+
+            bool ssse3  = false;
+            bool sha    = false;
+            bool avx2   = false;
+            bool avx512 = false;
+
+            static
+            const cpu &features( )
+            {
+                static const cpu res = detect( );
+                return res;
+            }
+
+        private:
+
+            static
+            cpu detect( )
+            {
+                cpu res;
+#ifdef BITCHAIN_SHA256_X86
+                unsigned a = 0, b = 0, c = 0, d = 0;
+                if( !__get_cpuid( 1, &a, &b, &c, &d ) ) {
+                    return res;
+                }
+                bool ssse3   = ( c & ( 1u <<  9 ) ) != 0;
+                bool sse41   = ( c & ( 1u << 19 ) ) != 0;
+                bool osxsave = ( c & ( 1u << 27 ) ) != 0;
+                bool avx     = ( c & ( 1u << 28 ) ) != 0;
+
+                std::uint64_t xcr0 = 0;
+                if( osxsave ) {
+                    unsigned lo = 0, hi = 0;
+                    __asm__ __volatile__ ( "xgetbv"
+                                         : "=a"(lo), "=d"(hi) : "c"(0) );
+                    xcr0 = ( static_cast<std::uint64_t>(hi) << 32 ) | lo;
+                }
+                bool ymm_state = ( xcr0 & 0x06 ) == 0x06;
+                bool zmm_state = ( xcr0 & 0xE6 ) == 0xE6;
+
+                res.ssse3 = ssse3;
+
+                if( __get_cpuid_max( 0, nullptr ) >= 7 ) {
+                    __cpuid_count( 7, 0, a, b, c, d );
+                    res.sha    = ssse3 && sse41 && ( b & ( 1u << 29 ) );
+                    res.avx2   = avx && ymm_state && ( b & ( 1u << 5 ) );
+                    res.avx512 = avx && zmm_state && ( b & ( 1u << 16 ) );
+                }
+#endif
+                return res;
+            }
+        };
+
+#ifdef BITCHAIN_SHA256_X86
+
+        __attribute__((target("sha,sse4.1,ssse3")))
+        static
+        void transform_shani( std::uint32_t state[8],
+                              const std::uint8_t *blocks, std::size_t count )
+        {
+            const __m128i mask = _mm_set_epi64x( 0x0c0d0e0f08090a0bULL,
+                                                 0x0405060700010203ULL );
+            const std::uint32_t *k = round_constants( );
+
+            __m128i tmp = _mm_loadu_si128(
+                        reinterpret_cast<const __m128i *>(&state[0]) );
+            __m128i st1 = _mm_loadu_si128(
+                        reinterpret_cast<const __m128i *>(&state[4]) );
+
+            tmp = _mm_shuffle_epi32( tmp, 0xB1 );          // CDAB
+            st1 = _mm_shuffle_epi32( st1, 0x1B );          // EFGH
+            __m128i st0 = _mm_alignr_epi8( tmp, st1, 8 );  // ABEF
+            st1 = _mm_blend_epi16( st1, tmp, 0xF0 );       // CDGH
+
+/// Four rounds on message word group 'M', followed by the schedule updates
+/// the reference SHA-NI sequence interleaves with them.
+#define BITCHAIN_SHANI_QUAD( i, M, PREV, NEXT, MSG2, MSG1 )                 \
+    msg = _mm_add_epi32( M, _mm_loadu_si128(                                \
+                reinterpret_cast<const __m128i *>(k + ( i ) * 4) ) );       \
+    st1 = _mm_sha256rnds2_epu32( st1, st0, msg );                           \
+    if( MSG2 ) {                                                            \
+        tmp  = _mm_alignr_epi8( M, PREV, 4 );                               \
+        NEXT = _mm_sha256msg2_epu32( _mm_add_epi32( NEXT, tmp ), M );       \
+    }                                                                       \
+    msg = _mm_shuffle_epi32( msg, 0x0E );                                   \
+    st0 = _mm_sha256rnds2_epu32( st0, st1, msg );                           \
+    if( MSG1 ) {                                                            \
+        PREV = _mm_sha256msg1_epu32( PREV, M );                             \
+    }
+
+            for( ; count > 0; --count, blocks += block_length ) {
+
+                __m128i abef = st0;
+                __m128i cdgh = st1;
+                __m128i msg;
+
+                __m128i m0 = _mm_shuffle_epi8( _mm_loadu_si128(
+                    reinterpret_cast<const __m128i *>(blocks +  0) ), mask );
+                __m128i m1 = _mm_shuffle_epi8( _mm_loadu_si128(
+                    reinterpret_cast<const __m128i *>(blocks + 16) ), mask );
+                __m128i m2 = _mm_shuffle_epi8( _mm_loadu_si128(
+                    reinterpret_cast<const __m128i *>(blocks + 32) ), mask );
+                __m128i m3 = _mm_shuffle_epi8( _mm_loadu_si128(
+                    reinterpret_cast<const __m128i *>(blocks + 48) ), mask );
+
+                BITCHAIN_SHANI_QUAD(  0, m0, m3, m1, false, false )
+                BITCHAIN_SHANI_QUAD(  1, m1, m0, m2, false, true  )
+                BITCHAIN_SHANI_QUAD(  2, m2, m1, m3, false, true  )
+                BITCHAIN_SHANI_QUAD(  3, m3, m2, m0, true,  true  )
+                BITCHAIN_SHANI_QUAD(  4, m0, m3, m1, true,  true  )
+                BITCHAIN_SHANI_QUAD(  5, m1, m0, m2, true,  true  )
+                BITCHAIN_SHANI_QUAD(  6, m2, m1, m3, true,  true  )
+                BITCHAIN_SHANI_QUAD(  7, m3, m2, m0, true,  true  )
+                BITCHAIN_SHANI_QUAD(  8, m0, m3, m1, true,  true  )
+                BITCHAIN_SHANI_QUAD(  9, m1, m0, m2, true,  true  )
+                BITCHAIN_SHANI_QUAD( 10, m2, m1, m3, true,  true  )
+                BITCHAIN_SHANI_QUAD( 11, m3, m2, m0, true,  true  )
+                BITCHAIN_SHANI_QUAD( 12, m0, m3, m1, true,  true  )
+                BITCHAIN_SHANI_QUAD( 13, m1, m0, m2, true,  false )
+                BITCHAIN_SHANI_QUAD( 14, m2, m1, m3, true,  false )
+                BITCHAIN_SHANI_QUAD( 15, m3, m2, m0, false, false )
+
+                st0 = _mm_add_epi32( st0, abef );
+                st1 = _mm_add_epi32( st1, cdgh );
+            }
+
+#undef BITCHAIN_SHANI_QUAD
+
+            tmp = _mm_shuffle_epi32( st0, 0x1B );          // FEBA
+            st1 = _mm_shuffle_epi32( st1, 0xB1 );          // DCHG
+            st0 = _mm_blend_epi16( tmp, st1, 0xF0 );       // DCBA
+            st1 = _mm_alignr_epi8( st1, tmp, 8 );          // HGFE
+
+            _mm_storeu_si128( reinterpret_cast<__m128i *>(&state[0]), st0 );
+            _mm_storeu_si128( reinterpret_cast<__m128i *>(&state[4]), st1 );
+        }
+
+        /// Big-endian digest written with two 16-byte stores, so a 32-byte
+        /// re-hash reading it back right away gets store forwarding.
+        __attribute__((target("ssse3")))
+        static
+        void store_digest_ssse3( const std::uint32_t state[8],
+                                 std::uint8_t *dst )
+        {
+            const __m128i mask = _mm_set_epi64x( 0x0c0d0e0f08090a0bULL,
+                                                 0x0405060700010203ULL );
+            __m128i lo = _mm_loadu_si128(
+                        reinterpret_cast<const __m128i *>(&state[0]) );
+            __m128i hi = _mm_loadu_si128(
+                        reinterpret_cast<const __m128i *>(&state[4]) );
+            _mm_storeu_si128( reinterpret_cast<__m128i *>(dst),
+                              _mm_shuffle_epi8( lo, mask ) );
+            _mm_storeu_si128( reinterpret_cast<__m128i *>(dst + 16),
+                              _mm_shuffle_epi8( hi, mask ) );
+        }
+
+/// Defines a struct 'Name' hashing up to 'Width' independent messages at
+/// once, one message per 32-bit lane of 'Vec'. Every helper carries the
+/// target attribute so the intrinsics inline into the kernel.
+#define BITCHAIN_SHA256_LANES_IMPL( Name, Target, Vec, Width,               \
+                                    ADD, XOR, OR, AND, ANDNOT,              \
+                                    SRLI, SLLI, SET1, LOADU, STOREU )       \
+                                                                            \
+    struct Name {                                                           \
+                                                                            \
+        enum { width = Width };                                             \
+        using vec = Vec;                                                    \
+                                                                            \
+        Target static inline vec add( vec a, vec b )                        \
+        { return ADD( a, b ); }                                             \
+                                                                            \
+        Target static inline vec xor3( vec a, vec b, vec c )                \
+        { return XOR( XOR( a, b ), c ); }                                   \
+                                                                            \
+        template <int N>                                                    \
+        Target static inline vec rotr( vec x )                              \
+        { return OR( SRLI( x, N ), SLLI( x, 32 - N ) ); }                   \
+                                                                            \
+        Target static inline vec bsig0( vec a )                             \
+        { return xor3( rotr<2>(a), rotr<13>(a), rotr<22>(a) ); }            \
+                                                                            \
+        Target static inline vec bsig1( vec e )                             \
+        { return xor3( rotr<6>(e), rotr<11>(e), rotr<25>(e) ); }            \
+                                                                            \
+        Target static inline vec ssig0( vec w )                             \
+        { return xor3( rotr<7>(w), rotr<18>(w), SRLI( w, 3 ) ); }           \
+                                                                            \
+        Target static inline vec ssig1( vec w )                             \
+        { return xor3( rotr<17>(w), rotr<19>(w), SRLI( w, 10 ) ); }         \
+                                                                            \
+        Target static inline vec ch( vec e, vec f, vec g )                  \
+        { return XOR( AND( e, f ), ANDNOT( e, g ) ); }                      \
+                                                                            \
+        Target static inline vec maj( vec a, vec b, vec c )                 \
+        { return OR( AND( a, b ), AND( c, OR( a, b ) ) ); }                 \
+                                                                            \
+        Target static inline vec load( const std::uint32_t *p )             \
+        { return LOADU( reinterpret_cast<const vec *>(p) ); }               \
+                                                                            \
+        Target static inline void store( std::uint32_t *p, vec v )          \
+        { STOREU( reinterpret_cast<vec *>(p), v ); }                        \
+                                                                            \
+        Target static                                                       \
+        void compress( vec s[8], vec w[16] )                                \
+        {                                                                   \
+            const std::uint32_t *k = round_constants( );                    \
+            vec a = s[0], b = s[1], c = s[2], d = s[3];                     \
+            vec e = s[4], f = s[5], g = s[6], h = s[7];                     \
+            for( int t=0; t<64; ++t ) {                                     \
+                vec wt;                                                     \
+                if( t < 16 ) {                                              \
+                    wt = w[t];                                              \
+                } else {                                                    \
+                    wt = add( add( w[t & 15], ssig0( w[( t + 1 ) & 15] ) ), \
+                              add( w[( t + 9 ) & 15],                       \
+                                   ssig1( w[( t + 14 ) & 15] ) ) );         \
+                    w[t & 15] = wt;                                         \
+                }                                                           \
+                vec t1 = add( add( h, bsig1( e ) ),                         \
+                              add( ch( e, f, g ),                           \
+                                   add( SET1( static_cast<int>(k[t]) ),     \
+                                        wt ) ) );                           \
+                vec t2 = add( bsig0( a ), maj( a, b, c ) );                 \
+                h = g; g = f; f = e; e = add( d, t1 );                      \
+                d = c; c = b; b = a; a = add( t1, t2 );                     \
+            }                                                               \
+            s[0] = add( s[0], a ); s[1] = add( s[1], b );                   \
+            s[2] = add( s[2], c ); s[3] = add( s[3], d );                   \
+            s[4] = add( s[4], e ); s[5] = add( s[5], f );                   \
+            s[6] = add( s[6], g ); s[7] = add( s[7], h );                   \
+        }                                                                   \
+                                                                            \
+        /* count <= width; lanes past 'count' hash an empty block */        \
+        Target static                                                       \
+        void hash( const padded_message *msg, std::size_t count,            \
+                   std::uint8_t *dst )                                      \
+        {                                                                   \
+            static const std::uint8_t zero_block[block_length] = { 0 };     \
+            alignas(64) std::uint32_t words[16][Width];                     \
+            alignas(64) std::uint32_t lanes[8][Width];                      \
+            const std::uint32_t *iv = initial_state( );                     \
+            std::size_t blocks = 0;                                         \
+            vec s[8];                                                       \
+            vec w[16];                                                      \
+                                                                            \
+            for( int j=0; j<8; ++j ) {                                      \
+                s[j] = SET1( static_cast<int>(iv[j]) );                     \
+            }                                                               \
+            for( std::size_t l=0; l<count; ++l ) {                          \
+                blocks = ( msg[l].blocks > blocks ) ? msg[l].blocks : blocks;\
+            }                                                               \
+                                                                            \
+            for( std::size_t id=0; id<blocks; ++id ) {                      \
+                for( std::size_t l=0; l<Width; ++l ) {                      \
+                    const std::uint8_t *p =                                 \
+                        ( l < count && id < msg[l].blocks )                 \
+                            ? msg[l].block( id ) : zero_block;              \
+                    for( int t=0; t<16; ++t ) {                             \
+                        words[t][l] = read_be32( p + t * 4 );               \
+                    }                                                       \
+                }                                                           \
+                for( int t=0; t<16; ++t ) {                                 \
+                    w[t] = load( words[t] );                                \
+                }                                                           \
+                compress( s, w );                                           \
+                                                                            \
+                bool stored = false;                                        \
+                for( std::size_t l=0; l<count; ++l ) {                      \
+                    if( msg[l].blocks != id + 1 ) {                         \
+                        continue;                                           \
+                    }                                                       \
+                    if( !stored ) {                                         \
+                        for( int j=0; j<8; ++j ) {                          \
+                            store( lanes[j], s[j] );                        \
+                        }                                                   \
+                        stored = true;                                      \
+                    }                                                       \
+                    for( int j=0; j<8; ++j ) {                              \
+                        write_be32( lanes[j][l],                            \
+                                    dst + l * digest_length + j * 4 );      \
+                    }                                                       \
+                }                                                           \
+            }                                                               \
+        }                                                                   \
+    }
+
+        BITCHAIN_SHA256_LANES_IMPL( lanes_avx2,
+            __attribute__((target("avx2"))), __m256i, 8,
+            _mm256_add_epi32, _mm256_xor_si256, _mm256_or_si256,
+            _mm256_and_si256, _mm256_andnot_si256,
+            _mm256_srli_epi32, _mm256_slli_epi32, _mm256_set1_epi32,
+            _mm256_loadu_si256, _mm256_storeu_si256 );
+
+        BITCHAIN_SHA256_LANES_IMPL( lanes_avx512,
+            __attribute__((target("avx512f"))), __m512i, 16,
+            _mm512_add_epi32, _mm512_xor_si512, _mm512_or_si512,
+            _mm512_and_si512, _mm512_andnot_si512,
+            _mm512_srli_epi32, _mm512_slli_epi32, _mm512_set1_epi32,
+            _mm512_loadu_si512, _mm512_storeu_si512 );
+
+#undef BITCHAIN_SHA256_LANES_IMPL
+
+#endif // BITCHAIN_SHA256_X86
+
+        /// Compresses 'count' consecutive 64-byte blocks into 'state' with
+        /// the fastest single-stream implementation available.
+        static
+        void transform( std::uint32_t state[8],
+                        const std::uint8_t *blocks, std::size_t count )
+        {
+#ifdef BITCHAIN_SHA256_X86
+            if( cpu::features( ).sha ) {
+                transform_shani( state, blocks, count );
+                return;
+            }
+#endif
+            transform_scalar( state, blocks, count );
+        }
+
+        static
+        void store( const std::uint32_t state[8], std::uint8_t *dst )
+        {
+#ifdef BITCHAIN_SHA256_X86
+            if( cpu::features( ).ssse3 ) {
+                store_digest_ssse3( state, dst );
+                return;
+            }
+#endif
+            store_digest( state, dst );
+        }
+
+        static
+        void hash_one( const padded_message &msg, std::uint8_t *dst )
+        {
+            std::uint32_t state[8];
+            memcpy( state, initial_state( ), sizeof(state) );
+            if( msg.full ) {
+                transform( state, msg.data, msg.full );
+            }
+            transform( state, msg.tail, msg.blocks - msg.full );
+            store( state, dst );
+        }
+
+        /// Hashes 'count' independent messages; digest i is written to
+        /// dst + i * digest_length.
+        /// SHA-NI is preferred when present: one message per call on the
+        /// dedicated unit beats the lane kernels. Otherwise messages are
+        /// grouped 16 (AVX-512) or 8 (AVX2) at a time.
+        static
+        void hash_many( const slice *src, std::uint8_t *dst, std::size_t count )
+        {
+            enum { max_lanes = 16 };
+            padded_message msg[max_lanes];
+
+            std::size_t lanes = 1;
+#ifdef BITCHAIN_SHA256_X86
+            const cpu &features = cpu::features( );
+            if( !features.sha ) {
+                if( features.avx512 ) {
+                    lanes = lanes_avx512::width;
+                } else if( features.avx2 ) {
+                    lanes = lanes_avx2::width;
+                }
+            }
+#endif
+            while( count > 0 ) {
+                std::size_t n = ( count < lanes ) ? count : lanes;
+                for( std::size_t l=0; l<n; ++l ) {
+                    msg[l].assign( src[l].get( ), src[l].size( ) );
+                }
+#ifdef BITCHAIN_SHA256_X86
+                if( n > 1 && lanes == lanes_avx512::width ) {
+                    lanes_avx512::hash( msg, n, dst );
+                } else if( n > 1 && lanes == lanes_avx2::width ) {
+                    lanes_avx2::hash( msg, n, dst );
+                } else
+#endif
+                {
+                    for( std::size_t l=0; l<n; ++l ) {
+                        hash_one( msg[l], dst + l * digest_length );
+                    }
+                }
+                src   += n;
+                dst   += n * digest_length;
+                count -= n;
+            }
+        }
+
+        /// Padding block of a 64-byte message; it never changes.
+        static
+        const std::uint8_t *padding64( )
+        {
+            static const std::uint8_t block[block_length] = {
+                0x80, 0, 0, 0, 0, 0, 0, 0,  0, 0, 0, 0, 0, 0, 0, 0,
+                0,    0, 0, 0, 0, 0, 0, 0,  0, 0, 0, 0, 0, 0, 0, 0,
+                0,    0, 0, 0, 0, 0, 0, 0,  0, 0, 0, 0, 0, 0, 0, 0,
+                0,    0, 0, 0, 0, 0, 0, 0,  0, 0, 0, 0, 0, 0, 0x02, 0x00,
+            };
+            return block;
+        }
+
+        /// SHA-256 of exactly 32 bytes: a single block whose padding is
+        /// known up front. 'dst' may alias 'src'.
+        static
+        void sha256_32( const std::uint8_t *src, std::uint8_t *dst )
+        {
+            std::uint32_t state[8];
+            std::uint8_t  block[block_length] = { 0 };
+
+            memcpy( state, initial_state( ), sizeof(state) );
+            memcpy( block, src, 32 );
+            block[32] = 0x80;
+            block[62] = 0x01;                       // 256 bits
+            transform( state, block, 1 );
+            store( state, dst );
+        }
+
+        /// SHA-256 of exactly 64 bytes (a merkle pair); the second block
+        /// is the constant padding64.
+        static
+        void sha256_64( const std::uint8_t *src, std::uint8_t *dst )
+        {
+            std::uint32_t state[8];
+
+            memcpy( state, initial_state( ), sizeof(state) );
+            transform( state, src, 1 );
+            transform( state, padding64( ), 1 );
+            store( state, dst );
+        }
+
+        /// SHA-256 of exactly 80 bytes (a block header).
+        static
+        void sha256_80( const std::uint8_t *src, std::uint8_t *dst )
+        {
+            std::uint32_t state[8];
+            std::uint8_t  block[block_length] = { 0 };
+
+            memcpy( state, initial_state( ), sizeof(state) );
+            memcpy( block, src + block_length, 16 );
+            block[16] = 0x80;
+            block[62] = 0x02;                       // 640 bits
+            block[63] = 0x80;
+            transform( state, src, 1 );
+            transform( state, block, 1 );
+            store( state, dst );
+        }
+    };
+
+    /// Double SHA-256 over an input whose length is known at compile
+    /// time. 32, 64 and 80 bytes (txid re-hash, merkle pair, header) have
+    /// dedicated kernels; other sizes go through the padded generic path.
+    template <std::size_t Len>
+    struct sha256d_fixed {
+        static
+        void get( const std::uint8_t *src, std::uint8_t *dst )
+        {
+            sha256_engine::hash_one( sha256_engine::padded_message(src, Len),
+                                     dst );
+            sha256_engine::sha256_32( dst, dst );
+        }
+    };
+
+    template <>
+    struct sha256d_fixed<32> {
+        static
+        void get( const std::uint8_t *src, std::uint8_t *dst )
+        {
+            sha256_engine::sha256_32( src, dst );
+            sha256_engine::sha256_32( dst, dst );
+        }
+    };
+
+    template <>
+    struct sha256d_fixed<64> {
+        static
+        void get( const std::uint8_t *src, std::uint8_t *dst )
+        {
+            sha256_engine::sha256_64( src, dst );
+            sha256_engine::sha256_32( dst, dst );
+        }
+    };
+
+    template <>
+    struct sha256d_fixed<80> {
+        static
+        void get( const std::uint8_t *src, std::uint8_t *dst )
+        {
+            sha256_engine::sha256_80( src, dst );
+            sha256_engine::sha256_32( dst, dst );
+        }
+    };
+
+} }
+
+#endif // SHA256_ENGINE_H
@@ -0,0 +1,207 @@
+#ifndef BLOCK_CHAIN_SIGHASH_H
+#define BLOCK_CHAIN_SIGHASH_H
+
+#include <cstdint>
+#include <vector>
+#include <string>
+
+#include "hash.h"
+#include "tx.h"
+
+namespace bchain { namespace tx {
+
+    /// Signature hashes for every input of one transaction, with the parts
+    /// shared between inputs computed once in the constructor.
+    ///
+    /// legacy( ): the original scheme, where input i's preimage is the
+    /// transaction with every other input's script emptied. The hash state
+    /// after the inputs before i is kept per input (midstate), and the
+    /// bytes after input i (the emptied inputs, outputs and locktime) are
+    /// serialised once. The scheme itself stays quadratic in the number of
+    /// inputs, but only the part after input i is rehashed.
+    ///
+    /// bip143( ): the segwit v0 scheme. hashPrevouts, hashSequence and
+    /// hashOutputs are computed once, so every input costs O(1).
+    class sighash_engine {
+
+    public:
+
+        using digest_type = transaction::digest_type;
+        using script_type = std::vector<std::uint8_t>;
+
+        explicit sighash_engine( const transaction &t )
+            :tx_(t)
+        {
+            const auto &ins = tx_.tx_in( );
+
+            /// legacy: midstates and the shared tail
+            hash_writer<hash::hash256> prefix;
+            string_writer tw(truncated_);
+
+            ser::write32( tx_.version( ), prefix );
+            ser::write_var( ins.size( ), prefix );
+            prefixes_.reserve( ins.size( ) );
+
+            for( auto &in: ins ) {
+                prefixes_.push_back( prefix.state( ) );
+                write_truncated( in, prefix );
+                write_truncated( in, tw );
+            }
+
+            string_writer ow(outputs_);
+            ser::write_var( tx_.tx_out( ).size( ), ow );
+            for( auto &o: tx_.tx_out( ) ) {
+                o.write_to( ow );
+            }
+            ser::write32( tx_.locktime( ), ow );
+
+            /// bip143: the three shared hashes
+            hash_writer<hash::hash256> prevouts;
+            hash_writer<hash::hash256> sequence;
+            for( auto &in: ins ) {
+                in.op.write_to( prevouts );
+                ser::write32( in.seq, sequence );
+            }
+            prevouts.final( hash_prevouts_.data( ) );
+            sequence.final( hash_sequence_.data( ) );
+
+            hash_writer<hash::hash256> outputs;
+            for( auto &o: tx_.tx_out( ) ) {
+                o.write_to( outputs );
+            }
+            outputs.final( hash_outputs_.data( ) );
+
+            /// version + hashPrevouts + hashSequence is more than one
+            /// block; keep the state after it
+            hash_writer<hash::hash256> head;
+            ser::write32( tx_.version( ), head );
+            ser::write_bytes( hash_prevouts_, head );
+            ser::write_bytes( hash_sequence_, head );
+            bip143_prefix_ = head.state( );
+        }
+
+        std::size_t size( ) const
+        {
+            return prefixes_.size( );
+        }
+
+        digest_type legacy( std::size_t index, const script_type &script_code,
+                            sighash flags = SIGHASH_ALL ) const
+        {
+            const auto &in = tx_.tx_in( )[index];
+            hash_writer<hash::hash256> w(prefixes_[index]);
+
+            in.op.write_to( w );
+            ser::write_var( script_code.size( ), w );
+            ser::write_bytes( script_code, w );
+            ser::write32( in.seq, w );
+
+            std::size_t after = ( index + 1 ) * truncated_size;
+            write_raw( truncated_.data( ) + after, truncated_.size( ) - after,
+                       w );
+            write_raw( outputs_.data( ), outputs_.size( ), w );
+            if( flags ) {
+                ser::write32( flags, w );
+            }
+
+            digest_type res;
+            w.final( res.data( ) );
+            return res;
+        }
+
+        /// The full legacy preimage, for inspection. legacy( ) hashes the
+        /// same bytes.
+        template <typename WriterT>
+        void write_legacy( std::size_t index, const script_type &script_code,
+                           sighash flags, WriterT &w ) const
+        {
+            const auto &ins = tx_.tx_in( );
+
+            ser::write32( tx_.version( ), w );
+            ser::write_var( ins.size( ), w );
+            for( std::size_t i=0; i<ins.size( ); ++i ) {
+                if( i == index ) {
+                    ins[i].op.write_to( w );
+                    ser::write_var( script_code.size( ), w );
+                    ser::write_bytes( script_code, w );
+                    ser::write32( ins[i].seq, w );
+                } else {
+                    write_truncated( ins[i], w );
+                }
+            }
+            write_raw( outputs_.data( ), outputs_.size( ), w );
+            if( flags ) {
+                ser::write32( flags, w );
+            }
+        }
+
+        digest_type bip143( std::size_t index, const script_type &script_code,
+                            std::uint64_t amount,
+                            sighash flags = SIGHASH_ALL ) const
+        {
+            const auto &in = tx_.tx_in( )[index];
+            hash_writer<hash::hash256> w(bip143_prefix_);
+
+            in.op.write_to( w );
+            ser::write_var( script_code.size( ), w );
+            ser::write_bytes( script_code, w );
+            ser::write64( amount, w );
+            ser::write32( in.seq, w );
+            w.write( hash_outputs_.data( ), hash_outputs_.size( ) );
+            ser::write32( tx_.locktime( ), w );
+            ser::write32( flags, w );
+
+            digest_type res;
+            w.final( res.data( ) );
+            return res;
+        }
+
+        const digest_type &hash_prevouts( ) const
+        {
+            return hash_prevouts_;
+        }
+
+        const digest_type &hash_sequence( ) const
+        {
+            return hash_sequence_;
+        }
+
+        const digest_type &hash_outputs( ) const
+        {
+            return hash_outputs_;
+        }
+
+    private:
+
+        /// outpoint (36) + empty script (1) + sequence (4)
+        enum { truncated_size = 32 + 4 + 1 + 4 };
+
+        template <typename WriterT>
+        static
+        void write_truncated( const input &in, WriterT &w )
+        {
+            in.op.write_to( w );
+            ser::write_var( 0, w );
+            ser::write32( in.seq, w );
+        }
+
+        template <typename WriterT>
+        static
+        void write_raw( const char *data, std::size_t len, WriterT &w )
+        {
+            w.write( reinterpret_cast<const std::uint8_t *>(data), len );
+        }
+
+        const transaction                   &tx_;
+        std::vector<hash::hash256::context>  prefixes_;
+        std::string                          truncated_;   /// every input
+        std::string                          outputs_;     /// with locktime
+        digest_type                          hash_prevouts_;
+        digest_type                          hash_sequence_;
+        digest_type                          hash_outputs_;
+        hash::hash256::context               bip143_prefix_;
+    };
+
+}}
+
+#endif // BLOCK_CHAIN_SIGHASH_H
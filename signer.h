@@ -0,0 +1,130 @@
+#ifndef BLOCK_CHAIN_SIGNER_H
+#define BLOCK_CHAIN_SIGNER_H
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <map>
+#include <tuple>
+#include <memory.h>
+
+#include "crypto.h"
+#include "tx.h"
+#include "sighash.h"
+#include "thread_pool.h"
+#include "watch_list.h"
+
+namespace bchain { namespace tx {
+
+    /// Signs every P2PKH input of a transaction. Sighashes and ECDSA
+    /// signatures are computed on a thread pool; the unlocking scripts are
+    /// written back in input order once all of them succeeded. Signatures
+    /// are RFC 6979 with low S, so the same transaction always gets the
+    /// same scripts.
+    class signer {
+
+    public:
+
+        /// inputs handed to a single worker
+        enum { grain = 4 };
+
+        explicit signer( transaction &t, thread_pool *pool = nullptr )
+            :tx_(t)
+            ,pool_(pool ? pool : &thread_pool::common( ))
+            ,items_(t.tx_in( ).size( ))
+        { }
+
+        /// 'key' must outlive sign( ) and is shared by every input it is
+        /// set for. false if 'index' is not an input of the transaction,
+        /// 'prevout' is not P2PKH or pays a hash other than that of the
+        /// key's public bytes in their current conversion form.
+        bool set_input( std::size_t index, const output &prevout,
+                        crypto::ec_key &key )
+        {
+            if( index >= items_.size( ) ) {
+                return false;
+            }
+
+            auto h = watch_list::p2pkh_hash( prevout );
+            if( !h ) {
+                return false;
+            }
+            auto pub = key.get_public_bytes( );
+            hash::hash160::digest_block pub_hash;
+            hash::hash160::get( pub_hash, pub.c_str( ), pub.size( ) );
+            if( pub.empty( ) || memcmp( pub_hash, h, sizeof(pub_hash) ) ) {
+                return false;
+            }
+
+            auto &it = items_[index];
+            it.script = prevout.script;
+            it.key    = &key;
+            it.pub    = std::move(pub);
+            it.nonces = &nonces_.emplace( std::piecewise_construct,
+                                          std::forward_as_tuple( &key ),
+                                          std::forward_as_tuple( key.get( ) ) )
+                            .first->second;
+            return true;
+        }
+
+        /// false if an input has no key, the inputs changed since the
+        /// signer was made or a signature failed; the transaction is left
+        /// untouched then.
+        bool sign( sighash flags = SIGHASH_ALL )
+        {
+            if( items_.size( ) != tx_.tx_in( ).size( ) ) {
+                return false;
+            }
+            for( auto &it: items_ ) {
+                if( !it.key || !*it.key || !it.nonces->valid( ) ) {
+                    return false;
+                }
+            }
+
+            const sighash_engine engine(tx_);
+            std::vector<std::string> ders(items_.size( ));
+
+            pool_->parallel_for( items_.size( ), grain,
+                [this, &engine, &ders, flags]( std::size_t b, std::size_t e ) {
+                    for( std::size_t i=b; i<e; ++i ) {
+                        auto &it = items_[i];
+                        auto d = engine.legacy( i, it.script, flags );
+                        ders[i] = crypto::signature::sign_rfc6979_der(
+                                        d.data( ), d.size( ), *it.nonces,
+                                        it.key->get( ) );
+                    }
+                } );
+
+            for( auto &d: ders ) {
+                if( d.empty( ) ) {
+                    return false;
+                }
+            }
+
+            for( std::size_t i=0; i<items_.size( ); ++i ) {
+                input in = tx_.tx_in( )[i];
+                in.fill( in.op, ders[i], items_[i].pub, flags );
+                in.seq = tx_.tx_in( )[i].seq;
+                tx_.set_input( i, std::move(in) );
+            }
+            return true;
+        }
+
+    private:
+
+        struct item {
+            std::vector<std::uint8_t>  script;
+            crypto::ec_key            *key = nullptr;
+            std::string                pub;
+            const crypto::rfc6979     *nonces = nullptr;
+        };
+
+        transaction        &tx_;
+        thread_pool        *pool_;
+        std::vector<item>   items_;
+        std::map<const crypto::ec_key *, crypto::rfc6979> nonces_;
+    };
+
+}}
+
+#endif // BLOCK_CHAIN_SIGNER_H
@@ -0,0 +1,97 @@
+#include <string>
+#include <random>
+#include <cstdint>
+
+#include "etool/details/byte_hex.h"
+
+#include "catch/catch.hpp"
+
+#include "base58.h"
+
+using namespace bchain;
+using namespace etool;
+
+namespace {
+
+    std::string operator "" _bin( const char *val, size_t len )
+    {
+        auto res = details::byte_hex::from_hex( val, len );
+        if( res ) {
+            return std::move(*res);
+        }
+        return "<FAILED>";
+    }
+
+    /// 'len' bytes with the first 'zeros' of them zero
+    std::string random_bytes( std::mt19937 &rng, size_t len, size_t zeros )
+    {
+        std::string res(len, '\0');
+        for( size_t i=zeros; i<len; ++i ) {
+            res[i] = static_cast<char>(rng( ) & 0xff);
+        }
+        return res;
+    }
+}
+
+TEST_CASE( "base58 known strings", "[base58]" )
+{
+    REQUIRE( base58::encode( std::string( ) ).empty( ) );
+    REQUIRE( base58::encode( std::string( "Hello World!" ) ) ==
+             "2NEpo7TZRRrLZSi2U" );
+    REQUIRE( base58::encode( "000000287fb4cd"_bin ) == "111233QC4" );
+    REQUIRE( base58::decode( "111233QC4" ) == "000000287fb4cd"_bin );
+
+    auto addr = "00f54a5851e9372b87810a8e60cdd2e7cfd80b6e31"_bin;
+    REQUIRE( base58::encode_check( addr.c_str( ), addr.size( ) ) ==
+             "1PMycacnJaSqwwJqjawXBErnLsZ7RkXUAs" );
+
+    auto dec = base58::decode_check( "1PMycacnJaSqwwJqjawXBErnLsZ7RkXUAs" );
+    REQUIRE( dec.second );
+    REQUIRE( dec.first == addr );
+}
+
+TEST_CASE( "base58 rejects bad input", "[base58]" )
+{
+    REQUIRE( base58::decode( "1PMycacnJaSqwwJqjawXBErnLsZ7RkXU0s" ).empty( ) );
+    REQUIRE( base58::decode( "1PMycacnJaSqwwJqjawXBErnLsZ7RkXUIs" ).empty( ) );
+    REQUIRE_FALSE( base58::decode_check(
+                        "1PMycacnJaSqwwJqjawXBErnLsZ7RkXUAt" ).second );
+
+    base58::decoded_buffer buf;
+    REQUIRE_FALSE( base58::decode_check( buf, "1111", 4 ) );
+}
+
+TEST_CASE( "base58 round trips", "[base58]" )
+{
+    std::mt19937 rng(58);
+
+    for( size_t len=0; len<=base58::max_payload + 16; ++len ) {
+        for( size_t zeros=0; zeros<=len && zeros<4; ++zeros ) {
+            auto src = random_bytes( rng, len, zeros );
+
+            auto enc = base58::encode( src );
+            REQUIRE( base58::decode( enc ) == src );
+
+            auto chk = base58::encode_check( src.c_str( ), src.size( ) );
+            auto dec = base58::decode_check( chk );
+            REQUIRE( dec.second );
+            REQUIRE( dec.first == src );
+        }
+    }
+
+    SECTION( "fixed-size kernels" ) {
+        for( int i=0; i<64; ++i ) {
+            auto src = random_bytes( rng, 25, i % 3 );
+            auto u8  = reinterpret_cast<const std::uint8_t *>(src.c_str( ));
+
+            std::uint8_t enc[base58::max_encoded + 1];
+            size_t len = base58::encode_fixed<25>( enc, u8 );
+            REQUIRE( std::string( reinterpret_cast<char *>(enc), len ) ==
+                     base58::encode( src ) );
+
+            std::uint8_t dec[25];
+            REQUIRE( base58::decode_fixed<25>( dec, enc, len ) );
+            REQUIRE( std::string( reinterpret_cast<char *>(dec), 25 ) == src );
+        }
+    }
+}
@@ -0,0 +1,164 @@
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "etool/details/byte_hex.h"
+
+#include "catch/catch.hpp"
+
+#include "bip32.h"
+
+using namespace bchain;
+using namespace bchain::crypto;
+using namespace etool;
+
+namespace {
+
+    std::string operator "" _bin( const char *val, size_t len )
+    {
+        auto res = details::byte_hex::from_hex( val, len );
+        if( res ) {
+            return std::move(*res);
+        }
+        return "<FAILED>";
+    }
+
+    extended_key master_1( )
+    {
+        auto seed = "000102030405060708090a0b0c0d0e0f"_bin;
+        extended_key res;
+        REQUIRE( bip32::from_seed( res,
+                    reinterpret_cast<const std::uint8_t *>(seed.c_str( )),
+                    seed.size( ) ) );
+        return res;
+    }
+
+    extended_key derive( const extended_key &root, const std::string &path )
+    {
+        std::vector<std::uint32_t> p;
+        REQUIRE( bip32::parse_path( p, path ) );
+        extended_key res;
+        REQUIRE( bip32::derive_path( res, root, p ) );
+        return res;
+    }
+
+    std::string xpub( const extended_key &k )
+    {
+        extended_key pub;
+        REQUIRE( bip32::neuter( pub, k ) );
+        return bip32::encode( pub );
+    }
+
+    bool same( const extended_key &a, const extended_key &b )
+    {
+        return bip32::encode( a ) == bip32::encode( b );
+    }
+}
+
+TEST_CASE( "bip32 test vector 1", "[crypto][bip32]" )
+{
+    auto m = master_1( );
+
+    SECTION( "m" ) {
+        REQUIRE( bip32::encode( m ) ==
+                 "xprv9s21ZrQH143K3QTDL4LXw2F7HEK3wJUD2nW2nRk4stbPy6cq3jPPq"
+                 "jiChkVvvNKmPGJxWUtg6LnF5kejMRNNU3TGtRBeJgk33yuGBxrMPHi" );
+        REQUIRE( xpub( m ) ==
+                 "xpub661MyMwAqRbcFtXgS5sYJABqqG9YLmC4Q1Rdap9gSE8NqtwybGheP"
+                 "Y2gZ29ESFjqJoCu1Rupje8YtGqsefD265TMg7usUDFdp6W1EGMcet8" );
+    }
+
+    SECTION( "m/0H" ) {
+        auto k = derive( m, "m/0H" );
+        REQUIRE( bip32::encode( k ) ==
+                 "xprv9uHRZZhk6KAJC1avXpDAp4MDc3sQKNxDiPvvkX8Br5ngLNv1TxvUx"
+                 "t4cV1rGL5hj6KCesnDYUhd7oWgT11eZG7XnxHrnYeSvkzY7d2bhkJ7" );
+        REQUIRE( xpub( k ) ==
+                 "xpub68Gmy5EdvgibQVfPdqkBBCHxA5htiqg55crXYuXoQRKfDBFA1WEjW"
+                 "gP6LHhwBZeNK1VTsfTFUHCdrfp1bgwQ9xv5ski8PX9rL2dZXvgGDnw" );
+    }
+
+    SECTION( "m/0H/1" ) {
+        const std::string xprv_exp =
+                 "xprv9wTYmMFdV23N2TdNG573QoEsfRrWKQgWeibmLntzniatZvR9BmLnv"
+                 "Sxqu53Kw1UmYPxLgboyZQaXwTCg8MSY3H2EU4pWcQDnRnrVA1xe8fs";
+        const std::string xpub_exp =
+                 "xpub6ASuArnXKPbfEwhqN6e3mwBcDTgzisQN1wXN9BJcM47sSikHjJf3U"
+                 "FHKkNAWbWMiGj7Wf5uMash7SyYq527Hqck2AxYysAA7xmALppuCkwQ";
+
+        auto k = derive( m, "m/0H/1" );
+        REQUIRE( bip32::encode( k ) == xprv_exp );
+        REQUIRE( xpub( k ) == xpub_exp );
+
+        /// the same child from the public parent
+        extended_key parent_pub;
+        REQUIRE( bip32::neuter( parent_pub, derive( m, "m/0H" ) ) );
+        extended_key child_pub;
+        REQUIRE( bip32::derive_child( child_pub, parent_pub, 1 ) );
+        REQUIRE( bip32::encode( child_pub ) == xpub_exp );
+
+        /// no hardened child under a public parent
+        extended_key none;
+        REQUIRE_FALSE( bip32::derive_child( none, parent_pub,
+                                            bip32::hardened | 1 ) );
+    }
+
+    SECTION( "m/0H/1/2H" ) {
+        auto k = derive( m, "m/0H/1/2H" );
+        REQUIRE( bip32::encode( k ) ==
+                 "xprv9z4pot5VBttmtdRTWfWQmoH1taj2axGVzFqSb8C9xaxKymcFzXBDp"
+                 "tWmT7FwuEzG3ryjH4ktypQSAewRiNMjANTtpgP4mLTj34bhnZX7UiM" );
+        REQUIRE( xpub( k ) ==
+                 "xpub6D4BDPcP2GT577Vvch3R8wDkScZWzQzMMUm3PWbmWvVJrZwQY4VUN"
+                 "gqFJPMM3No2dFDFGTsxxpG5uJh7n7epu4trkrX7x7DogT5Uv6fcLW5" );
+    }
+
+    SECTION( "encode and decode round trip" ) {
+        auto k = derive( m, "m/0H/1/2H" );
+        extended_key back;
+        REQUIRE( bip32::decode( back, bip32::encode( k ) ) );
+        REQUIRE( same( back, k ) );
+    }
+}
+
+TEST_CASE( "bip32 derive_range matches derive_child", "[crypto][bip32]" )
+{
+    auto parent = derive( master_1( ), "m/0H/1" );
+
+    /// across the hardened boundary
+    const std::uint32_t first = bip32::hardened - 40;
+    const std::size_t   count = 80;
+
+    SECTION( "private parent" ) {
+        std::vector<extended_key> range(count);
+        REQUIRE( bip32::derive_range( parent, first, count, range.data( ) ) );
+
+        for( std::size_t i=0; i<count; ++i ) {
+            extended_key child;
+            REQUIRE( bip32::derive_child( child, parent,
+                                 first + static_cast<std::uint32_t>(i) ) );
+            REQUIRE( same( range[i], child ) );
+        }
+    }
+
+    SECTION( "public parent" ) {
+        extended_key parent_pub;
+        REQUIRE( bip32::neuter( parent_pub, parent ) );
+
+        std::vector<extended_key> range(count);
+        REQUIRE_FALSE( bip32::derive_range( parent_pub, first, count,
+                                            range.data( ) ) );
+
+        for( std::size_t i=0; i<count; ++i ) {
+            auto index = first + static_cast<std::uint32_t>(i);
+            extended_key child;
+            if( index < bip32::hardened ) {
+                REQUIRE( bip32::derive_child( child, parent_pub, index ) );
+                REQUIRE( same( range[i], child ) );
+            } else {
+                REQUIRE_FALSE( bip32::derive_child( child, parent_pub,
+                                                    index ) );
+            }
+        }
+    }
+}
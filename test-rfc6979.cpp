@@ -0,0 +1,77 @@
+#include <string>
+#include <cstdint>
+
+#include "etool/details/byte_hex.h"
+
+#include "catch/catch.hpp"
+
+#include "hash.h"
+#include "crypto.h"
+
+using namespace bchain;
+using namespace etool;
+
+namespace {
+
+    std::string operator "" _bin( const char *val, size_t len )
+    {
+        auto res = details::byte_hex::from_hex( val, len );
+        if( res ) {
+            return std::move(*res);
+        }
+        return "<FAILED>";
+    }
+
+    /// DER of the low-S deterministic signature of sha256( message )
+    std::string sign( const std::string &priv, const std::string &message )
+    {
+        auto k = crypto::ec_key::create_private( priv.c_str( ), priv.size( ) );
+        REQUIRE( k );
+
+        hash::sha256::digest_block digest;
+        hash::sha256::get( digest, message.c_str( ), message.size( ) );
+
+        crypto::rfc6979 nonces(k.get( ));
+        REQUIRE( nonces.valid( ) );
+        return crypto::signature::sign_rfc6979_der( digest, sizeof(digest),
+                                                    nonces, k.get( ) );
+    }
+
+    const std::string key_one = "00000000000000000000000000000000"
+                                "00000000000000000000000000000001"_bin;
+}
+
+TEST_CASE( "rfc6979 signatures match the published secp256k1 vectors",
+           "[crypto][rfc6979]" )
+{
+    SECTION( "key 1, 'Satoshi Nakamoto'" ) {
+        REQUIRE( sign( key_one, "Satoshi Nakamoto" ) ==
+                 "3045"
+                 "022100"
+                 "934b1ea10a4b3c1757e2b0c017d0b614"
+                 "3ce3c9a7e6a4a49860d7a6ab210ee3d8"
+                 "0220"
+                 "2442ce9d2b916064108014783e923ec3"
+                 "6b49743e2ffa1c4496f01a512aafd9e5"_bin );
+    }
+
+    SECTION( "key 1, 'All those moments...'" ) {
+        REQUIRE( sign( key_one, "All those moments will be lost in time, "
+                                "like tears in rain. Time to die..." ) ==
+                 "3045"
+                 "022100"
+                 "8600dbd41e348fe5c9465ab92d23e3db"
+                 "8b98b873beecd930736488696438cb6b"
+                 "0220"
+                 "547fe64427496db33bf66019dacbf003"
+                 "9c04199abb0122918601db38a72cfc21"_bin );
+    }
+}
+
+TEST_CASE( "rfc6979 signatures are reproducible", "[crypto][rfc6979]" )
+{
+    auto priv = "16260783e40b16731673622ac8a5b045"
+                "fc3ea4af70f727f3f9e92bdd3a1ddc42"_bin;
+    REQUIRE( sign( priv, "message" ) == sign( priv, "message" ) );
+    REQUIRE( sign( priv, "message" ) != sign( priv, "massage" ) );
+}
@@ -0,0 +1,133 @@
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "etool/details/byte_hex.h"
+
+#include "catch/catch.hpp"
+
+#include "hash.h"
+#include "tx.h"
+#include "sighash.h"
+
+using namespace bchain;
+using namespace etool;
+
+namespace {
+
+    std::string operator "" _bin( const char *val, size_t len )
+    {
+        auto res = details::byte_hex::from_hex( val, len );
+        if( res ) {
+            return std::move(*res);
+        }
+        return "<FAILED>";
+    }
+
+    std::vector<std::uint8_t> to_script( const std::string &bytes )
+    {
+        return std::vector<std::uint8_t>( bytes.begin( ), bytes.end( ) );
+    }
+
+    std::string to_string( const tx::transaction::digest_type &d )
+    {
+        return std::string( d.begin( ), d.end( ) );
+    }
+
+    /// 'txid' as serialised, not in display order
+    tx::input make_input( const std::string &txid, std::uint32_t index,
+                          std::uint32_t seq )
+    {
+        tx::input res;
+        std::copy( txid.begin( ), txid.end( ), res.op.txid.begin( ) );
+        res.op.index = index;
+        res.seq      = seq;
+        return res;
+    }
+
+    tx::output make_output( std::uint64_t value, const std::string &script )
+    {
+        tx::output res;
+        res.value  = value;
+        res.script = to_script( script );
+        return res;
+    }
+}
+
+TEST_CASE( "bip143 native P2WPKH example", "[tx][sighash]" )
+{
+    tx::transaction t;
+    t.set_version( 1 );
+    t.add_input( make_input( "fff7f7881a8099afa6940d42d1e7f636"
+                             "2bec38171ea3edf433541db4e4ad969f"_bin,
+                             0, 0xffffffee ) );
+    t.add_input( make_input( "ef51e1b804cc89d182d279655c3aa89e"
+                             "815b1b309fe287d9b2b55d57b90ec68a"_bin,
+                             1, 0xffffffff ) );
+    t.add_output( make_output( 112340000,
+                               "76a9148280b37df378db99f66f85c95a78"
+                               "3a76ac7a6d5988ac"_bin ) );
+    t.add_output( make_output( 223450000,
+                               "76a9143bde42dbee7e4dbe6a21b2d50ce2"
+                               "f0167faa815988ac"_bin ) );
+    t.set_locktime( 17 );
+
+    tx::sighash_engine engine(t);
+
+    REQUIRE( to_string( engine.hash_prevouts( ) ) ==
+             "96b827c8483d4e9b96712b6713a7b68d"
+             "6e8003a781feba36c31143470b4efd37"_bin );
+    REQUIRE( to_string( engine.hash_sequence( ) ) ==
+             "52b0a642eea2fb7ae638c36f6252b675"
+             "0293dbe574a806984b8e4d8548339a3b"_bin );
+    REQUIRE( to_string( engine.hash_outputs( ) ) ==
+             "863ef3e1a92afbfdb97f31ad0fc7683e"
+             "e943e9abcf2501590ff8f6551f47e5e5"_bin );
+
+    auto script_code = to_script( "76a9141d0f172a0ecb48aee1be1f2687d2"
+                                  "963ae33f71a188ac"_bin );
+    REQUIRE( to_string( engine.bip143( 1, script_code, 600000000 ) ) ==
+             "c37af31116d1b27caf68aae9e3ac82f1"
+             "477929014d5b917657d0eb49478cb670"_bin );
+}
+
+TEST_CASE( "legacy preimage of a one input P2PKH spend", "[tx][sighash]" )
+{
+    const auto preimage = "0100000001f3a27f485f9833c8318c490403307f"
+                          "ef1397121b5dd8fe70777236e7371c4ef3000000"
+                          "001976a9146bf19e55f94d986b4640c154d86469"
+                          "934191951188acffffffff02e0fe7e0100000000"
+                          "1976a91418ba14b3682295cb05230e31fecb0008"
+                          "9240660888ace084b003000000001976a9146bf1"
+                          "9e55f94d986b4640c154d86469934191951188ac"
+                          "0000000001000000"_bin;
+
+    tx::output   outs[2];
+    tx::output   prev;
+    tx::input    in;
+    tx::outpoint op;
+
+    outs[0].fill( 25100000, "18ba14b3682295cb05230e31fecb000892406608"_bin );
+    outs[1].fill( 61900000, "6bf19e55f94d986b4640c154d864699341919511"_bin );
+    prev.fill( 87000000, "6bf19e55f94d986b4640c154d864699341919511"_bin );
+    op.fill( "f34e1c37e736727770fed85d1b129713"
+             "ef7f300304498c31c833985f487fa2f3"_bin, 0 );
+    in.fill_truncated( op );
+
+    tx::transaction t;
+    t.add_output( outs[0] );
+    t.add_output( outs[1] );
+    t.add_input( in );
+
+    tx::sighash_engine engine(t);
+
+    std::string res;
+    tx::string_writer w(res);
+    engine.write_legacy( 0, prev.script, tx::SIGHASH_ALL, w );
+    REQUIRE( res == preimage );
+
+    hash::hash256::digest_block digest;
+    hash::hash256::get( digest, preimage.c_str( ), preimage.size( ) );
+    REQUIRE( to_string( engine.legacy( 0, prev.script, tx::SIGHASH_ALL ) ) ==
+             std::string( digest, digest + sizeof(digest) ) );
+}
@@ -0,0 +1,189 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <exception>
+
+namespace bchain {
+
+    class thread_pool {
+
+    public:
+
+        using task_type  = std::function<void ( )>;
+        using range_call = std::function<void (std::size_t, std::size_t)>;
+
+        /// threads == 0 means one worker per hardware thread
+        explicit thread_pool( std::size_t threads = 0 )
+        {
+            if( threads == 0 ) {
+                threads = std::thread::hardware_concurrency( );
+            }
+            if( threads == 0 ) {
+                threads = 1;
+            }
+            workers_.reserve( threads );
+            for( std::size_t i=0; i<threads; ++i ) {
+                workers_.emplace_back( [this]( ) { run( ); } );
+            }
+        }
+
+        ~thread_pool( )
+        {
+            {
+                std::lock_guard<std::mutex> lck(lock_);
+                stopped_ = true;
+            }
+            cond_.notify_all( );
+            for( auto &w: workers_ ) {
+                w.join( );
+            }
+        }
+
+        thread_pool( const thread_pool & ) = delete;
+        thread_pool &operator = ( const thread_pool & ) = delete;
+
+        /// Process-wide pool sized to the machine.
+        static
+        thread_pool &common( )
+        {
+            static thread_pool inst;
+            return inst;
+        }
+
+        std::size_t size( ) const
+        {
+            return workers_.size( );
+        }
+
+        void post( task_type task )
+        {
+            {
+                std::lock_guard<std::mutex> lck(lock_);
+                tasks_.push_back( std::move(task) );
+            }
+            cond_.notify_one( );
+        }
+
+        /// Splits [0, count) into chunks of at most 'grain' items and calls
+        /// call(begin, end) for each of them on the workers. The caller
+        /// takes chunks too, so nested calls from a worker cannot deadlock.
+        /// The first exception thrown by 'call' is rethrown here after all
+        /// chunks are finished.
+        void parallel_for( std::size_t count, std::size_t grain,
+                           range_call call )
+        {
+            if( grain == 0 ) {
+                grain = 1;
+            }
+            if( count <= grain || size( ) < 2 ) {
+                if( count > 0 ) {
+                    call( 0, count );
+                }
+                return;
+            }
+
+            auto st = std::make_shared<range_state>( count, grain,
+                                                     std::move(call) );
+            std::size_t helpers = st->chunks - 1;
+            if( helpers > size( ) ) {
+                helpers = size( );
+            }
+            for( std::size_t i=0; i<helpers; ++i ) {
+                post( [st]( ) { st->work( ); } );
+            }
+            st->work( );
+            st->wait( );
+        }
+
+    private:
+
+        struct range_state {
+
+            range_state( std::size_t cnt, std::size_t grn, range_call c )
+                :count(cnt)
+                ,grain(grn)
+                ,chunks((cnt + grn - 1) / grn)
+                ,left(chunks)
+                ,call(std::move(c))
+            { }
+
+            void work( )
+            {
+                std::size_t id;
+                while( ( id = next.fetch_add( 1 ) ) < chunks ) {
+                    std::size_t b = id * grain;
+                    std::size_t e = ( b + grain < count ) ? b + grain : count;
+                    try {
+                        call( b, e );
+                    } catch( ... ) {
+                        std::lock_guard<std::mutex> lck(lock);
+                        if( !error ) {
+                            error = std::current_exception( );
+                        }
+                    }
+                    if( --left == 0 ) {
+                        std::lock_guard<std::mutex> lck(lock);
+                        cond.notify_all( );
+                    }
+                }
+            }
+
+            void wait( )
+            {
+                std::unique_lock<std::mutex> lck(lock);
+                cond.wait( lck, [this]( ) { return left == 0; } );
+                if( error ) {
+                    std::rethrow_exception( error );
+                }
+            }
+
+            const std::size_t        count;
+            const std::size_t        grain;
+            const std::size_t        chunks;
+            std::atomic<std::size_t> next { 0 };
+            std::atomic<std::size_t> left;
+            range_call               call;
+            std::mutex               lock;
+            std::condition_variable  cond;
+            std::exception_ptr       error;
+        };
+
+        void run( )
+        {
+            while( true ) {
+                task_type task;
+                {
+                    std::unique_lock<std::mutex> lck(lock_);
+                    cond_.wait( lck, [this]( ) {
+                        return stopped_ || !tasks_.empty( );
+                    } );
+                    if( tasks_.empty( ) ) {
+                        return;
+                    }
+                    task = std::move(tasks_.front( ));
+                    tasks_.pop_front( );
+                }
+                task( );
+            }
+        }
+
+        std::vector<std::thread> workers_;
+        std::deque<task_type>    tasks_;
+        std::mutex               lock_;
+        std::condition_variable  cond_;
+        bool                     stopped_ = false;
+    };
+
+}
+
+#endif // THREAD_POOL_H
@@ -6,6 +6,12 @@
 #include <deque>
 #include <array>
 #include <algorithm>
+#include <atomic>
+#include <string>
+#include <memory.h>
+
+#include "hash.h"
+#include "varint.h"
 
 #include "etool/details/byte_order.h"
 #include "etool/sizepack/blockchain_varint.h"
@@ -33,6 +39,134 @@ namespace bchain { namespace tx {
         }
     };
 
+    /// Sinks for the write_to( ) serialisers. Anything with
+    /// write( const std::uint8_t *, std::size_t ) works as one.
+
+    /// Raw memory. It does no bounds checks of its own: the caller sizes
+    /// the buffer from size( ) once, up front.
+    class buffer_writer {
+
+    public:
+
+        explicit buffer_writer( std::uint8_t *dst )
+            :pos_(dst)
+        { }
+
+        void write( const std::uint8_t *src, std::size_t len )
+        {
+            if( len ) {
+                memcpy( pos_, src, len );
+                pos_ += len;
+            }
+        }
+
+        std::uint8_t *position( ) const
+        {
+            return pos_;
+        }
+
+    private:
+        std::uint8_t *pos_;
+    };
+
+    class string_writer {
+
+    public:
+
+        explicit string_writer( std::string &out )
+            :out_(out)
+        { }
+
+        void write( const std::uint8_t *src, std::size_t len )
+        {
+            out_.append( reinterpret_cast<const char *>(src), len );
+        }
+
+    private:
+        std::string &out_;
+    };
+
+    template <typename OstreamT>
+    class stream_writer {
+
+    public:
+
+        explicit stream_writer( OstreamT &os )
+            :os_(os)
+        { }
+
+        void write( const std::uint8_t *src, std::size_t len )
+        {
+            os_.write( reinterpret_cast<const char *>(src),
+                       static_cast<std::streamsize>(len) );
+        }
+
+    private:
+        OstreamT &os_;
+    };
+
+    /// Feeds serialised bytes straight into a streaming hash (any HashT
+    /// with a nested context, e.g. hash::hash256), so nothing is
+    /// materialised. Small field writes are staged in a local block.
+    template <typename HashT>
+    class hash_writer {
+
+    public:
+
+        using digest_block = typename HashT::digest_block;
+        using context_type = typename HashT::context;
+
+        hash_writer( ) = default;
+
+        /// Continues from a saved midstate.
+        explicit hash_writer( const context_type &ctx )
+            :ctx_(ctx)
+        { }
+
+        void write( const std::uint8_t *src, std::size_t len )
+        {
+            if( !len ) {
+                return;
+            }
+            if( fill_ + len > sizeof(stage_) ) {
+                flush( );
+                if( len >= sizeof(stage_) ) {
+                    ctx_.update( src, len );
+                    return;
+                }
+            }
+            memcpy( &stage_[fill_], src, len );
+            fill_ += len;
+        }
+
+        void final( digest_block dst )
+        {
+            flush( );
+            ctx_.final( dst );
+        }
+
+        /// Midstate of everything written so far.
+        context_type state( )
+        {
+            flush( );
+            return ctx_;
+        }
+
+    private:
+
+        void flush( )
+        {
+            if( fill_ ) {
+                ctx_.update( stage_, fill_ );
+                fill_ = 0;
+            }
+        }
+
+        context_type ctx_;
+        std::uint8_t stage_[256];
+        std::size_t  fill_ = 0;
+    };
+
     struct ser {
 
         static
@@ -42,29 +176,87 @@ namespace bchain { namespace tx {
             return bo_var::result_length( len );
         }
 
+        template <typename WriterT>
         static
-        void append32( std::uint32_t val, std::string &out )
+        void write32( std::uint32_t val, WriterT &w )
         {
             using bo32 = order::little<std::uint32_t>;
-            auto s = out.size( );
-            out.resize( s + sizeof(std::uint32_t) );
-            bo32::write( val, &out[s] );
+            std::uint8_t buf[sizeof(std::uint32_t)];
+            bo32::write( val, buf );
+            w.write( buf, sizeof(buf) );
         }
 
+        template <typename WriterT>
         static
-        void append64( std::uint64_t val, std::string &out )
+        void write64( std::uint64_t val, WriterT &w )
         {
             using bo64 = order::little<std::uint64_t>;
-            auto s = out.size( );
-            out.resize( s + sizeof(std::uint64_t) );
-            bo64::write( val, &out[s] );
+            std::uint8_t buf[sizeof(std::uint64_t)];
+            bo64::write( val, buf );
+            w.write( buf, sizeof(buf) );
+        }
+
+        template <typename WriterT>
+        static
+        void write_var( std::uint64_t val, WriterT &w )
+        {
+            std::uint8_t buf[varint::max_length];
+            w.write( buf, varint::write( val, buf ) );
+        }
+
+        template <typename WriterT, typename ContT>
+        static
+        void write_bytes( const ContT &bytes, WriterT &w )
+        {
+            w.write( bytes.data( ), bytes.size( ) );
+        }
+
+        static
+        void append32( std::uint32_t val, std::string &out )
+        {
+            string_writer w(out);
+            write32( val, w );
+        }
+
+        static
+        void append64( std::uint64_t val, std::string &out )
+        {
+            string_writer w(out);
+            write64( val, w );
         }
 
         static
         void append_var( std::uint64_t val, std::string &out )
         {
-            using bo_var = etool::sizepack::blockchain_varint;
-            bo_var::append( val, out );
+            string_writer w(out);
+            write_var( val, w );
+        }
+
+        /// Grows 'out' once by obj.size( args ) and writes into that space.
+        template <typename ObjT, typename ...Args>
+        static
+        void append_obj( const ObjT &obj, std::string &out, Args ...args )
+        {
+            auto s = out.size( );
+            out.resize( s + obj.size( args... ) );
+            buffer_writer w(reinterpret_cast<std::uint8_t *>(&out[s]));
+            obj.write_to( args..., w );
+        }
+
+        /// One bounds check for the whole object. Returns the number of
+        /// bytes written, 0 if 'cap' is too small.
+        template <typename ObjT, typename ...Args>
+        static
+        std::size_t write_obj( const ObjT &obj, std::uint8_t *dst,
+                               std::size_t cap, Args ...args )
+        {
+            auto len = obj.size( args... );
+            if( len > cap ) {
+                return 0;
+            }
+            buffer_writer w(dst);
+            obj.write_to( args..., w );
+            return len;
         }
     };
 
@@ -81,11 +273,17 @@ namespace bchain { namespace tx {
             return res;
         }
 
+        template <typename WriterT>
+        void write_to( WriterT &w ) const
+        {
+            ser::write64( value, w );
+            ser::write_var( script.size( ), w );
+            ser::write_bytes( script, w );
+        }
+
         void serialize_to( std::string &out ) const
         {
-            ser::append64( value, out );
-            ser::append_var( script.size( ), out );
-            out.append( script.begin( ), script.end( ) );
+            ser::append_obj( *this, out );
         }
 
         void fill( std::uint64_t val, const std::string &hash160 )
@@ -115,10 +313,16 @@ namespace bchain { namespace tx {
             return res;
         }
 
+        template <typename WriterT>
+        void write_to( WriterT &w ) const
+        {
+            ser::write_bytes( txid, w );
+            ser::write32( index, w );
+        }
+
         void serialize_to( std::string &out ) const
         {
-            out.append( txid.begin( ), txid.end( ) );
-            ser::append32( index, out );
+            ser::append_obj( *this, out );
         }
 
         void fill( const std::string &tid, std::uint32_t idx )
@@ -143,12 +347,18 @@ namespace bchain { namespace tx {
             return res;
         }
 
+        template <typename WriterT>
+        void write_to( WriterT &w ) const
+        {
+            op.write_to( w );
+            ser::write_var( script.size( ), w );
+            ser::write_bytes( script, w );
+            ser::write32( seq, w );
+        }
+
         void serialize_to( std::string &out ) const
         {
-            op.serialize_to( out );
-            ser::append_var( script.size( ), out );
-            out.append( script.begin( ), script.end( ) );
-            ser::append32( seq, out );
+            ser::append_obj( *this, out );
         }
 
         void fill( outpoint out, const std::string &sig,
@@ -183,27 +393,119 @@ namespace bchain { namespace tx {
 
     struct transaction {
 
-        std::uint32_t       version = 1;
-        std::deque<input>   tx_in;
-        std::deque<output>  tx_out;
-        std::uint32_t       locktime = 0;
+        using digest_type = std::array<std::uint8_t, 32>;
+
+        transaction( ) = default;
+
+        std::uint32_t version( ) const
+        {
+            return version_;
+        }
+
+        void set_version( std::uint32_t val )
+        {
+            touch( );
+            version_ = val;
+        }
+
+        std::uint32_t locktime( ) const
+        {
+            return locktime_;
+        }
+
+        void set_locktime( std::uint32_t val )
+        {
+            touch( );
+            locktime_ = val;
+        }
+
+        const std::deque<input> &tx_in( ) const
+        {
+            return tx_in_;
+        }
+
+        const std::deque<output> &tx_out( ) const
+        {
+            return tx_out_;
+        }
+
+        void add_input( input val )
+        {
+            touch( );
+            tx_in_.emplace_back( std::move(val) );
+        }
+
+        void set_input( std::size_t index, input val )
+        {
+            touch( );
+            tx_in_[index] = std::move(val);
+        }
+
+        void add_output( output val )
+        {
+            touch( );
+            tx_out_.emplace_back( std::move(val) );
+        }
+
+        void set_output( std::size_t index, output val )
+        {
+            touch( );
+            tx_out_[index] = std::move(val);
+        }
+
+        /// Forgets the cached ids.
+        void touch( )
+        {
+            txid_.reset( );
+        }
+
+        /// hash256 of the serialised transaction in internal byte order.
+        /// Computed on first use and cached until the transaction changes.
+        digest_type txid( ) const
+        {
+            digest_type res;
+            if( txid_.get( res ) ) {
+                return res;
+            }
+
+            res = digest( SIGHASH_NON );
+            txid_.set( res );
+            return res;
+        }
+
+        /// hash256 of the serialisation with 'flags', hashed as it is
+        /// written. SIGHASH_NON gives the (uncached) txid.
+        digest_type digest( sighash flags ) const
+        {
+            digest_type res;
+            hash_writer<hash::hash256> w;
+            write_to( flags, w );
+            w.final( res.data( ) );
+            return res;
+        }
+
+        /// No witness data in this format, so wtxid is the txid (BIP141).
+        digest_type wtxid( ) const
+        {
+            return txid( );
+        }
 
         std::size_t size( sighash flags ) const
         {
             std::size_t res = 0;
 
-            res += sizeof( version );
-            res += ser::varint_size( tx_in.size( ) );
-            for( auto &i: tx_in ) {
+            res += sizeof( version_ );
+            res += ser::varint_size( tx_in_.size( ) );
+            for( auto &i: tx_in_ ) {
                 res += i.size( );
             }
 
-            res += ser::varint_size( tx_out.size( ) );
-            for( auto &o: tx_out ) {
+            res += ser::varint_size( tx_out_.size( ) );
+            for( auto &o: tx_out_ ) {
                 res += o.size( );
             }
 
-            res += sizeof(locktime);
+            res += sizeof(locktime_);
 
             if( flags ) {
                 res += sizeof(std::uint32_t);
@@ -212,28 +514,111 @@ namespace bchain { namespace tx {
             return res;
         }
 
-        void serialize_to( sighash flags, std::string &out ) const
+        template <typename WriterT>
+        void write_to( sighash flags, WriterT &w ) const
         {
-            ser::append32( version, out );
+            ser::write32( version_, w );
 
-            ser::append_var( tx_in.size( ), out );
-            for( auto &i: tx_in ) {
-                i.serialize_to( out );
+            ser::write_var( tx_in_.size( ), w );
+            for( auto &i: tx_in_ ) {
+                i.write_to( w );
             }
 
-            ser::append_var( tx_out.size( ), out );
-            for( auto &o: tx_out ) {
-                o.serialize_to( out );
+            ser::write_var( tx_out_.size( ), w );
+            for( auto &o: tx_out_ ) {
+                o.write_to( w );
             }
 
-            ser::append32( locktime, out );
+            ser::write32( locktime_, w );
 
             if( flags ) {
-                ser::append32( flags, out );
+                ser::write32( flags, w );
             }
         }
-    };
 
+        /// Appends to 'out' with a single allocation.
+        void serialize_to( sighash flags, std::string &out ) const
+        {
+            ser::append_obj( *this, out, flags );
+        }
+
+        /// Writes into caller memory with a single bounds check.
+        /// Returns the number of bytes written, 0 if 'cap' is too small.
+        std::size_t serialize_to( sighash flags, std::uint8_t *dst,
+                                  std::size_t cap ) const
+        {
+            return ser::write_obj( *this, dst, cap, flags );
+        }
+
+    private:
+
+        /// Lock-free once-cell: concurrent readers of a const transaction
+        /// may all compute the id, only one publishes it.
+        class id_cache {
+
+        public:
+
+            id_cache( ) = default;
+
+            id_cache( const id_cache &o )
+            {
+                copy( o );
+            }
+
+            id_cache &operator = ( const id_cache &o )
+            {
+                copy( o );
+                return *this;
+            }
+
+            bool get( digest_type &out ) const
+            {
+                if( state_.load( std::memory_order_acquire ) == READY ) {
+                    out = value_;
+                    return true;
+                }
+                return false;
+            }
+
+            void set( const digest_type &val ) const
+            {
+                int expected = EMPTY;
+                if( state_.compare_exchange_strong( expected, BUSY ) ) {
+                    value_ = val;
+                    state_.store( READY, std::memory_order_release );
+                }
+            }
+
+            void reset( )
+            {
+                state_.store( EMPTY, std::memory_order_relaxed );
+            }
+
+        private:
+
+            enum { EMPTY = 0, BUSY = 1, READY = 2 };
+
+            void copy( const id_cache &o )
+            {
+                digest_type val;
+                if( o.get( val ) ) {
+                    value_ = val;
+                    state_.store( READY, std::memory_order_release );
+                } else {
+                    reset( );
+                }
+            }
+
+            mutable std::atomic<int> state_ { EMPTY };
+            mutable digest_type      value_;
+        };
+
+        std::uint32_t       version_ = 1;
+        std::deque<input>   tx_in_;
+        std::deque<output>  tx_out_;
+        std::uint32_t       locktime_ = 0;
+        id_cache            txid_;
+    };
 
 
 }}
@@ -0,0 +1,571 @@
+#ifndef BLOCK_CHAIN_VANITY_H
+#define BLOCK_CHAIN_VANITY_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory.h>
+
+#include "openssl/rand.h"
+
+#include "crypto.h"
+#include "base58.h"
+#include "address.h"
+#include "thread_pool.h"
+
+namespace bchain { namespace address {
+
+    /// Looks for a key whose P2PKH address starts with a given string.
+    ///
+    /// Every worker starts from its own random private key k and walks
+    /// k, k + 1, k + 2, ... by adding G to the previous point, so a
+    /// candidate costs one point addition instead of a scalar multiply.
+    /// A batch of batch_size points is made affine with one inversion
+    /// and hashed with hash160::get_many. Nothing is base58 encoded on
+    /// the way: the prefix is turned once into ranges of the 21-byte
+    /// version || hash160 head, and a candidate is encoded only when its
+    /// head falls inside one of them.
+    class vanity {
+
+    public:
+
+        enum { batch_size = 256 };
+
+        /// version + hash160
+        enum { head_size = 1 + hash::hash160::digest_length };
+
+        using head = std::array<std::uint8_t, head_size>;
+
+        struct match {
+            std::string  priv;       /// 32 bytes, big endian
+            std::string  address;
+            bool         compressed = true;
+        };
+
+        vanity( const std::string &prefix,
+                std::uint8_t version = p2pkh::VERSION_MAINNET,
+                bool compressed = true )
+            :prefix_(prefix)
+            ,version_(version)
+            ,compressed_(compressed)
+        {
+            make_ranges( );
+        }
+
+        vanity( const vanity & ) = delete;
+        vanity &operator = ( const vanity & ) = delete;
+
+        /// false if no address of this version can start with the prefix
+        bool valid( ) const
+        {
+            return !ranges_.empty( );
+        }
+
+        /// Average number of keys to try for one match.
+        double expected_keys( ) const
+        {
+            return expected_;
+        }
+
+        /// Runs one walk per pool thread until a match is found, stop( )
+        /// is called or about 'limit' keys were tried (0 for no limit).
+        /// False if nothing was found.
+        bool search( match &out, std::uint64_t limit = 0,
+                     thread_pool *pool = nullptr )
+        {
+            if( !valid( ) ) {
+                return false;
+            }
+            thread_pool &tp = pool ? *pool : thread_pool::common( );
+
+            found_   = false;
+            stopped_ = false;
+            keys_    = 0;
+            limit_   = limit;
+            elapsed_ = -1;
+            started_ = now( );
+
+            tp.parallel_for( tp.size( ), 1,
+                [this]( std::size_t b, std::size_t e ) {
+                    for( ; b<e; ++b ) {
+                        walk( );
+                    }
+                } );
+
+            elapsed_ = now( ) - started_;
+
+            std::lock_guard<std::mutex> lck(lock_);
+            if( found_ ) {
+                out = result_;
+            }
+            return found_;
+        }
+
+        /// may be called from any thread while search( ) runs
+        void stop( )
+        {
+            stopped_ = true;
+        }
+
+        /// Keys tried by the running or the last search.
+        std::uint64_t keys( ) const
+        {
+            return keys_.load( std::memory_order_relaxed );
+        }
+
+        double seconds( ) const
+        {
+            std::int64_t ns = elapsed_;
+            if( ns < 0 ) {
+                ns = now( ) - started_;
+            }
+            return static_cast<double>(ns) / 1e9;
+        }
+
+        double keys_per_second( ) const
+        {
+            double s = seconds( );
+            return s > 0 ? static_cast<double>(keys( )) / s : 0.0;
+        }
+
+    private:
+
+        /// big endian, wide enough for (R + 1) * 58^n past 2^200
+        using wide = std::array<std::uint8_t, 32>;
+
+        struct range {
+            head lo;
+            head hi;    /// inclusive
+        };
+
+        /// Payload V = version || hash160 || checksum, read as a 200-bit
+        /// number. Its encoding is one '1' per leading zero byte followed
+        /// by the digits of V, so "z ones, then digits R" means exactly z
+        /// leading zero bytes and, for some length L,
+        /// R * 58^L <= V < (R + 1) * 58^L. Each L gives one interval of
+        /// V; dropping the 32 checksum bits turns it into an interval of
+        /// heads that may be one head too wide at either end, which the
+        /// final encode settles.
+        void make_ranges( )
+        {
+            enum { payload_size = p2pkh::payload_size };
+
+            const std::size_t len = prefix_.size( );
+            if( len == 0 || len > base58::encoded_size( payload_size ) ) {
+                return;
+            }
+            std::vector<std::uint8_t> digits(len);
+            using cu8 = const std::uint8_t;
+            if( !base58::map_digits( &digits[0],
+                                     reinterpret_cast<cu8 *>(prefix_.c_str( )),
+                                     len ) )
+            {
+                return;
+            }
+
+            std::size_t zeros = 0;
+            while( zeros < len && digits[zeros] == 0 ) {
+                ++zeros;
+            }
+            if( zeros > payload_size ) {
+                return;
+            }
+
+            /// the version byte, and exactly 'zeros' zero bytes in front
+            wide ver_lo = power256( payload_size - 1 );
+            wide ver_hi = ver_lo;
+            mul_add( ver_lo, version_, 0 );
+            mul_add( ver_hi, version_ + 1u, 0 );
+
+            wide zero_hi = power256( payload_size - zeros );
+            wide zero_lo = zeros < payload_size && zeros < len
+                         ? power256( payload_size - zeros - 1 ) : wide( );
+
+            wide lo_bound = max_of( ver_lo, zero_lo );
+            wide hi_bound = min_of( ver_hi, zero_hi );
+
+            /// only ones: at least that many zero bytes is enough
+            if( zeros == len ) {
+                if( less( lo_bound, hi_bound ) ) {
+                    add_range( lo_bound, hi_bound );
+                    expected_ = ( to_double( ver_hi ) - to_double( ver_lo ) )
+                              / ( to_double( hi_bound ) - to_double( lo_bound ) );
+                }
+                return;
+            }
+
+            wide r = wide( );
+            for( std::size_t i=zeros; i<len; ++i ) {
+                mul_add( r, 58, digits[i] );
+            }
+            wide r1 = r;
+            mul_add( r1, 1, 1 );
+
+            double total = 0;
+            while( true ) {
+                wide lo = max_of( r, lo_bound );
+                wide hi = min_of( r1, hi_bound );
+                if( less( lo, hi ) ) {
+                    add_range( lo, hi );
+                    total += to_double( hi ) - to_double( lo );
+                }
+                if( !less( r, hi_bound ) ) {
+                    break;
+                }
+                mul_add( r,  58, 0 );
+                mul_add( r1, 58, 0 );
+            }
+
+            if( total > 0 ) {
+                expected_ = ( to_double( ver_hi ) - to_double( ver_lo ) )
+                          / total;
+            }
+        }
+
+        /// [lo, hi) of payloads to the inclusive head range
+        void add_range( const wide &lo, wide hi )
+        {
+            enum { skip = sizeof(wide) - head_size - 4 };
+
+            /// hi - 1
+            for( std::size_t i=hi.size( ); i-- > 0; ) {
+                if( hi[i]-- != 0 ) {
+                    break;
+                }
+            }
+            range res;
+            memcpy( res.lo.data( ), lo.data( ) + skip, head_size );
+            memcpy( res.hi.data( ), hi.data( ) + skip, head_size );
+            ranges_.push_back( res );
+        }
+
+        bool in_ranges( const std::uint8_t *h ) const
+        {
+            for( auto &r: ranges_ ) {
+                if( memcmp( h, r.lo.data( ), head_size ) >= 0 &&
+                    memcmp( h, r.hi.data( ), head_size ) <= 0 )
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void walk( )
+        {
+            using slice = hash::hash160::slice;
+
+            const std::size_t len = crypto::ec_key::public_size( compressed_ );
+
+            std::uint8_t start[32];
+            walker       w;
+            if( !random_key( start ) || !w.init( start ) ) {
+                return;
+            }
+
+            std::vector<std::uint8_t>       pubs(batch_size * len);
+            hash::hash160::digest_block     hashes[batch_size];
+            slice                           src[batch_size];
+            for( std::size_t i=0; i<batch_size; ++i ) {
+                src[i] = slice( &pubs[i * len], len );
+            }
+
+            std::uint64_t offset = 0;
+            while( !stopped_ ) {
+                if( !w.next( &pubs[0], compressed_ ) ) {
+                    break;
+                }
+                hash::hash160::get_many( src, hashes, batch_size );
+
+                for( std::size_t i=0; i<batch_size; ++i ) {
+                    std::uint8_t h[head_size];
+                    h[0] = version_;
+                    memcpy( h + 1, hashes[i], hash::hash160::digest_length );
+                    if( in_ranges( h ) ) {
+                        check( h, start, offset + i, &pubs[i * len], len );
+                    }
+                }
+
+                offset += batch_size;
+                auto total = keys_.fetch_add( batch_size,
+                                              std::memory_order_relaxed )
+                           + batch_size;
+                if( limit_ && total >= limit_ ) {
+                    stopped_ = true;
+                }
+            }
+            OPENSSL_cleanse( start, sizeof(start) );
+        }
+
+        /// A head inside a range: encode for real and, on a match,
+        /// rebuild the private key start + offset and make sure it gives
+        /// the same public key.
+        void check( const std::uint8_t *h, const std::uint8_t *start,
+                    std::uint64_t offset, const std::uint8_t *pub,
+                    std::size_t len )
+        {
+            enum { payload_size = p2pkh::payload_size };
+
+            std::uint8_t body[payload_size];
+            hash::hash256::digest_block sum;
+            hash::hash256::get( sum, h, head_size );
+            memcpy( body, h, head_size );
+            memcpy( body + head_size, sum, 4 );
+
+            std::uint8_t enc[base58::max_encoded];
+            std::size_t  n = base58::encode_fixed<payload_size>( enc, body );
+            if( n < prefix_.size( ) ||
+                memcmp( enc, prefix_.c_str( ), prefix_.size( ) ) != 0 )
+            {
+                return;
+            }
+
+            std::uint8_t priv[32];
+            std::uint8_t again[65];
+            if( !add_offset( priv, start, offset ) ||
+                !crypto::ec_key::derive_public_many( priv, 1, again,
+                                                     compressed_ ) ||
+                memcmp( again, pub, len ) != 0 )
+            {
+                OPENSSL_cleanse( priv, sizeof(priv) );
+                return;
+            }
+
+            std::lock_guard<std::mutex> lck(lock_);
+            if( !found_ ) {
+                result_.priv.assign( priv, priv + sizeof(priv) );
+                result_.address.assign( enc, enc + n );
+                result_.compressed = compressed_;
+                found_ = true;
+            }
+            stopped_ = true;
+            OPENSSL_cleanse( priv, sizeof(priv) );
+        }
+
+        static
+        bool random_key( std::uint8_t *out )
+        {
+            const BIGNUM *order =
+                    EC_GROUP_get0_order( crypto::curve::secp256k1( ) );
+            crypto::bignum k;
+            if( !order || !k ) {
+                return false;
+            }
+            do {
+                if( 1 != RAND_bytes( out, 32 ) ) {
+                    return false;
+                }
+                BN_bin2bn( out, 32, k.get( ) );
+            } while( BN_is_zero( k.get( ) ) || BN_cmp( k.get( ), order ) >= 0 );
+            BN_clear( k.get( ) );
+            return true;
+        }
+
+        /// out = start + offset mod n
+        static
+        bool add_offset( std::uint8_t *out, const std::uint8_t *start,
+                         std::uint64_t offset )
+        {
+            const BIGNUM *order =
+                    EC_GROUP_get0_order( crypto::curve::secp256k1( ) );
+            crypto::bignum  k;
+            crypto::bignum  off;
+            crypto::bn_ctx  ctx;
+            std::uint8_t    ob[8];
+            for( int i=0; i<8; ++i ) {
+                ob[i] = static_cast<std::uint8_t>(offset >> ( 56 - i * 8 ));
+            }
+            bool res = order && k && off && ctx
+                    && BN_bin2bn( start, 32, k.get( ) )
+                    && BN_bin2bn( ob, sizeof(ob), off.get( ) )
+                    && 1 == BN_mod_add( k.get( ), k.get( ), off.get( ), order,
+                                        ctx.get( ) )
+                    && !BN_is_zero( k.get( ) )
+                    && 32 == BN_bn2binpad( k.get( ), out, 32 );
+            if( k ) {
+                BN_clear( k.get( ) );
+            }
+            return res;
+        }
+
+#if defined(BITCHAIN_NATIVE_SECP256K1)
+
+        /// P, P + G, ... in Jacobian form, one batched to_affine
+        struct walker {
+
+            bool init( const std::uint8_t *start )
+            {
+                secp256k1::scalar k;
+                bool res = secp256k1::scalar::set_bytes( k, start )
+                        && !k.is_zero( );
+                if( res ) {
+                    next_ = secp256k1::ecmult::gen( k );
+                }
+                OPENSSL_cleanse( &k, sizeof(k) );
+                return res;
+            }
+
+            bool next( std::uint8_t *out, bool compressed )
+            {
+                const auto &g = secp256k1::ge::generator( );
+                for( std::size_t i=0; i<batch_size; ++i ) {
+                    jac_[i] = next_;
+                    next_   = secp256k1::gej::add_ge( next_, g );
+                }
+                secp256k1::points::to_affine( jac_, batch_size, aff_ );
+
+                std::size_t len = compressed ? 33 : 65;
+                for( std::size_t i=0; i<batch_size; ++i ) {
+                    if( aff_[i].infinity ) {
+                        memset( out + i * len, 0, len );
+                    } else {
+                        aff_[i].serialize( out + i * len, compressed );
+                    }
+                }
+                return true;
+            }
+
+            secp256k1::gej  next_;
+            secp256k1::gej  jac_[batch_size];
+            secp256k1::ge   aff_[batch_size];
+        };
+
+#else
+
+        /// P, P + G, ... with EC_POINT_add; ec_point::serialize_many
+        /// makes the batch affine with one inversion
+        struct walker {
+
+            walker( )
+                :group_(crypto::curve::secp256k1( ))
+                ,next_(group_)
+            {
+                pts_.reserve( batch_size );
+                for( std::size_t i=0; i<batch_size; ++i ) {
+                    pts_.emplace_back( group_ );
+                    raw_[i] = pts_.back( ).get( );
+                }
+            }
+
+            bool init( const std::uint8_t *start )
+            {
+                crypto::bignum k;
+                bool res = group_ && next_ && k
+                        && BN_bin2bn( start, 32, k.get( ) )
+                        && 1 == EC_POINT_mul( group_, next_.get( ), k.get( ),
+                                              nullptr, nullptr, ctx_.get( ) );
+                if( k ) {
+                    BN_clear( k.get( ) );
+                }
+                return res;
+            }
+
+            bool next( std::uint8_t *out, bool compressed )
+            {
+                const EC_POINT *g = EC_GROUP_get0_generator( group_ );
+                for( std::size_t i=0; i<batch_size; ++i ) {
+                    if( !raw_[i] ||
+                        1 != EC_POINT_copy( raw_[i], next_.get( ) ) ||
+                        1 != EC_POINT_add( group_, next_.get( ), next_.get( ),
+                                           g, ctx_.get( ) ) )
+                    {
+                        return false;
+                    }
+                }
+                /// a point at infinity leaves zeroes, which never match
+                crypto::ec_point::serialize_many( group_, raw_, batch_size,
+                                                  out, compressed,
+                                                  ctx_.get( ) );
+                return true;
+            }
+
+            const EC_GROUP            *group_;
+            crypto::bn_ctx             ctx_;
+            crypto::ec_point           next_;
+            std::vector<crypto::ec_point> pts_;
+            EC_POINT                  *raw_[batch_size];
+        };
+
+#endif
+
+        static
+        std::int64_t now( )
+        {
+            using namespace std::chrono;
+            return duration_cast<nanoseconds>(
+                        steady_clock::now( ).time_since_epoch( ) ).count( );
+        }
+
+        static
+        wide power256( std::size_t n )
+        {
+            wide res = wide( );
+            res[res.size( ) - 1 - n] = 1;
+            return res;
+        }
+
+        /// v = v * m + a
+        static
+        void mul_add( wide &v, std::uint32_t m, std::uint32_t a )
+        {
+            std::uint64_t carry = a;
+            for( std::size_t i=v.size( ); i-- > 0; ) {
+                carry += static_cast<std::uint64_t>(v[i]) * m;
+                v[i]   = static_cast<std::uint8_t>(carry);
+                carry >>= 8;
+            }
+        }
+
+        static
+        bool less( const wide &a, const wide &b )
+        {
+            return memcmp( a.data( ), b.data( ), a.size( ) ) < 0;
+        }
+
+        static
+        const wide &max_of( const wide &a, const wide &b )
+        {
+            return less( a, b ) ? b : a;
+        }
+
+        static
+        const wide &min_of( const wide &a, const wide &b )
+        {
+            return less( a, b ) ? a : b;
+        }
+
+        static
+        double to_double( const wide &v )
+        {
+            double res = 0;
+            for( auto c: v ) {
+                res = res * 256 + c;
+            }
+            return res;
+        }
+
+        std::string         prefix_;
+        std::uint8_t        version_;
+        bool                compressed_;
+        std::vector<range>  ranges_;
+        double              expected_ = 0;
+
+        std::atomic<bool>           stopped_ { false };
+        std::atomic<std::uint64_t>  keys_    { 0 };
+        std::uint64_t               limit_   = 0;
+        std::atomic<std::int64_t>   started_ { 0 };
+        std::atomic<std::int64_t>   elapsed_ { 0 };
+
+        std::mutex  lock_;
+        bool        found_ = false;
+        match       result_;
+    };
+
+}}
+
+#endif // BLOCK_CHAIN_VANITY_H
@@ -0,0 +1,260 @@
+#ifndef BLOCK_CHAIN_VERIFY_CACHE_H
+#define BLOCK_CHAIN_VERIFY_CACHE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <memory.h>
+
+#include "openssl/rand.h"
+
+#include "crypto.h"
+#include "hash.h"
+
+namespace bchain { namespace crypto {
+
+    /// Remembers successful ECDSA verifications, so a signature checked
+    /// once (say on relay) costs a lookup when the same transaction shows
+    /// up again inside a block.
+    ///
+    /// Entries are SHA-256 of a random per-cache salt, the digest, the
+    /// compressed public key and r || s; the salt keeps anyone from
+    /// steering entries into one bucket. The set is split into shards,
+    /// each with its own lock and a fixed open-addressing table. A full
+    /// probe window evicts one of its slots, so memory stays at
+    /// 'capacity' entries. Failed verifications are never stored.
+    class verify_cache {
+
+    public:
+
+        using entry = std::array<std::uint8_t, hash::sha256::digest_length>;
+
+        enum { shard_count      = 16 };
+        enum { probe_length     = 8 };
+        enum { default_capacity = 1 << 17 };
+
+        /// longest compressed point we key on (P-521)
+        enum { max_point_length = 1 + 66 };
+
+        /// rounded up to a power of two, at least
+        /// shard_count * probe_length entries
+        explicit verify_cache( std::size_t capacity = default_capacity )
+        {
+            std::size_t per_shard = probe_length;
+            while( per_shard * shard_count < capacity ) {
+                per_shard <<= 1;
+            }
+            for( auto &s: shards_ ) {
+                s.slots.assign( per_shard, entry( ) );
+            }
+
+            std::uint8_t salt[hash::sha256_engine::block_length];
+            if( 1 != RAND_bytes( salt, sizeof(salt) ) ) {
+                /// still correct, only predictable
+                memset( salt, 0, sizeof(salt) );
+            }
+            salted_.update( salt, sizeof(salt) );
+        }
+
+        verify_cache( const verify_cache & ) = delete;
+        verify_cache &operator = ( const verify_cache & ) = delete;
+
+        /// Process-wide cache.
+        static
+        verify_cache &common( )
+        {
+            static verify_cache inst;
+            return inst;
+        }
+
+        /// Same results as signature::verify: 1 valid, 0 invalid, -1 error.
+        template <typename U>
+        int verify( const U *digest, size_t len, const compact_signature &sig,
+                    EC_KEY *k )
+        {
+            entry e;
+            if( !make_entry( e, digest, len, sig, k ) ) {
+                return signature::verify( digest, len, sig, k );
+            }
+            if( contains( e ) ) {
+                return 1;
+            }
+            auto res = signature::verify( digest, len, sig, k );
+            if( res == 1 ) {
+                insert( e );
+            }
+            return res;
+        }
+
+        template <typename U>
+        int verify( const U *digest, size_t len, ECDSA_SIG *sig, EC_KEY *k )
+        {
+            compact_signature c;
+            if( !compact_signature::from_sig( c, sig ) ) {
+                return signature::verify( digest, len, sig, k );
+            }
+            return verify( digest, len, c, k );
+        }
+
+        template <typename U, typename HashT = hash::sha256>
+        int hash_and_verify( const U *mess, size_t len, ECDSA_SIG *sig,
+                             EC_KEY *k )
+        {
+            typename HashT::digest_block digest;
+            HashT::get( digest, mess, len * sizeof(U) );
+            return verify( &digest[0], HashT::digest_length, sig, k );
+        }
+
+        /// false if the key has no public point to key on
+        template <typename U>
+        bool make_entry( entry &out, const U *digest, size_t len,
+                         const compact_signature &sig, const EC_KEY *k ) const
+        {
+            const EC_POINT *pub   = k ? EC_KEY_get0_public_key( k ) : nullptr;
+            const EC_GROUP *group = k ? EC_KEY_get0_group( k ) : nullptr;
+            std::uint8_t point[max_point_length];
+            if( !pub || ec_point::encoded_size( group, true ) > sizeof(point) ) {
+                return false;
+            }
+            bn_ctx ctx;
+            auto plen = EC_POINT_point2oct( group, pub,
+                                            POINT_CONVERSION_COMPRESSED,
+                                            point, sizeof(point), ctx.get( ) );
+            if( plen == 0 ) {
+                return false;
+            }
+
+            std::uint8_t dlen = static_cast<std::uint8_t>(len * sizeof(U));
+            auto sha = salted_;
+            sha.update( &dlen, 1 );
+            sha.update( digest, len );
+            sha.update( point, plen );
+            sha.update( sig.r.data( ), sig.r.size( ) );
+            sha.update( sig.s.data( ), sig.s.size( ) );
+            sha.final( out.data( ) );
+            return true;
+        }
+
+        /// counts a hit or a miss
+        bool contains( const entry &e )
+        {
+            auto &s = shard_of( e );
+            bool found = false;
+            {
+                std::lock_guard<std::mutex> lck(s.lock);
+                found = s.find( e ) != nullptr;
+            }
+            ( found ? s.hits : s.misses ).fetch_add( 1,
+                                                std::memory_order_relaxed );
+            return found;
+        }
+
+        void insert( const entry &e )
+        {
+            auto &s = shard_of( e );
+            std::lock_guard<std::mutex> lck(s.lock);
+            if( s.find( e ) ) {
+                return;
+            }
+            auto mask  = s.slots.size( ) - 1;
+            auto start = index_of( e );
+            for( std::size_t i=0; i<probe_length; ++i ) {
+                auto &slot = s.slots[( start + i ) & mask];
+                if( is_empty( slot ) ) {
+                    slot = e;
+                    return;
+                }
+            }
+            s.slots[( start + s.evict++ % probe_length ) & mask] = e;
+        }
+
+        void clear( )
+        {
+            for( auto &s: shards_ ) {
+                std::lock_guard<std::mutex> lck(s.lock);
+                s.slots.assign( s.slots.size( ), entry( ) );
+            }
+        }
+
+        std::uint64_t hits( ) const
+        {
+            std::uint64_t res = 0;
+            for( auto &s: shards_ ) {
+                res += s.hits.load( std::memory_order_relaxed );
+            }
+            return res;
+        }
+
+        std::uint64_t misses( ) const
+        {
+            std::uint64_t res = 0;
+            for( auto &s: shards_ ) {
+                res += s.misses.load( std::memory_order_relaxed );
+            }
+            return res;
+        }
+
+        std::size_t capacity( ) const
+        {
+            return shards_[0].slots.size( ) * shard_count;
+        }
+
+    private:
+
+        struct shard {
+
+            const entry *find( const entry &e ) const
+            {
+                auto mask  = slots.size( ) - 1;
+                auto start = index_of( e );
+                for( std::size_t i=0; i<probe_length; ++i ) {
+                    auto &slot = slots[( start + i ) & mask];
+                    if( slot == e ) {
+                        return &slot;
+                    }
+                }
+                return nullptr;
+            }
+
+            std::mutex                  lock;
+            std::vector<entry>          slots;
+            std::size_t                 evict = 0;
+            std::atomic<std::uint64_t>  hits   { 0 };
+            std::atomic<std::uint64_t>  misses { 0 };
+        };
+
+        /// entries are uniform hashes already: the first byte picks the
+        /// shard, the next eight the slot
+        shard &shard_of( const entry &e )
+        {
+            return shards_[e[0] % shard_count];
+        }
+
+        static
+        std::size_t index_of( const entry &e )
+        {
+            std::uint64_t res;
+            memcpy( &res, e.data( ) + 1, sizeof(res) );
+            return static_cast<std::size_t>(res);
+        }
+
+        static
+        bool is_empty( const entry &e )
+        {
+            std::uint8_t acc = 0;
+            for( auto c: e ) {
+                acc |= c;
+            }
+            return acc == 0;
+        }
+
+        hash::sha256::context   salted_;
+        shard                   shards_[shard_count];
+    };
+
+}}
+
+#endif // BLOCK_CHAIN_VERIFY_CACHE_H
@@ -0,0 +1,317 @@
+#ifndef BLOCK_CHAIN_WATCH_LIST_H
+#define BLOCK_CHAIN_WATCH_LIST_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <array>
+#include <memory.h>
+
+#include "tx.h"
+#include "base58.h"
+#include "thread_pool.h"
+
+namespace bchain { namespace tx {
+
+    /// Set of watched hash160s and a matcher for output scripts paying
+    /// them.
+    ///
+    /// Keys are hash outputs already, so their own bytes are the hash:
+    /// bytes 0..3 pick the slot, bytes 4..7 a 32-bit tag. Tags sit in
+    /// one dense array, probed linearly (16 to a cache line), and the
+    /// 20-byte keys in a parallel one that is only read when a tag
+    /// matches. Load stays at or below one half, so a miss, the common
+    /// case in a rescan, mostly costs one cache line.
+    class watch_list {
+
+    public:
+
+        enum { key_size = 20 };
+
+        using key_type = std::array<std::uint8_t, key_size>;
+
+        /// transactions handed to a single worker by scan( )
+        enum { scan_grain = 256 };
+
+        /// outputs whose slots are prefetched before they are probed
+        enum { probe_batch = 32 };
+
+        /// a paying output: transaction index in the batch, output index
+        struct hit {
+            std::size_t    tx;
+            std::uint32_t  output;
+        };
+
+        explicit watch_list( std::size_t expected = 0 )
+        {
+            reserve( expected );
+        }
+
+        /// room for 'count' keys without another rehash
+        void reserve( std::size_t count )
+        {
+            std::size_t cap = min_capacity;
+            while( cap < count * 2 ) {
+                cap <<= 1;
+            }
+            if( cap > tags_.size( ) ) {
+                rehash( cap );
+            }
+        }
+
+        /// false if it was there already
+        bool insert( const std::uint8_t *h160 )
+        {
+            if( ( size_ + 1 ) * 2 > tags_.size( ) ) {
+                rehash( tags_.empty( ) ? std::size_t(min_capacity)
+                                       : tags_.size( ) * 2 );
+            }
+            if( !place( h160 ) ) {
+                return false;
+            }
+            ++size_;
+            return true;
+        }
+
+        /// 'h160' holds the raw 20 bytes
+        bool insert( const std::string &h160 )
+        {
+            if( h160.size( ) != key_size ) {
+                return false;
+            }
+            return insert( reinterpret_cast<const std::uint8_t *>(
+                                                        h160.c_str( ) ) );
+        }
+
+        /// Watches a base58 P2PKH address of any version. False if it
+        /// does not decode to one.
+        bool insert_address( const std::string &addr )
+        {
+            base58::decoded_buffer buf;
+            if( !base58::decode_check( buf, addr.c_str( ), addr.size( ) )
+                || buf.size != 1 + key_size )
+            {
+                return false;
+            }
+            insert( buf.data + 1 );
+            return true;
+        }
+
+        bool contains( const std::uint8_t *h160 ) const
+        {
+            if( size_ == 0 ) {
+                return false;
+            }
+            const std::size_t mask = tags_.size( ) - 1;
+            const std::uint32_t tag = tag_of( h160 );
+            for( std::size_t i = slot_of( h160 ) & mask; ; i = ( i + 1 ) & mask ) {
+                if( tags_[i] == tag &&
+                    memcmp( keys_[i].data( ), h160, key_size ) == 0 )
+                {
+                    return true;
+                }
+                if( tags_[i] == 0 ) {
+                    return false;
+                }
+            }
+        }
+
+        std::size_t size( ) const
+        {
+            return size_;
+        }
+
+        std::size_t capacity( ) const
+        {
+            return tags_.size( );
+        }
+
+        void clear( )
+        {
+            std::vector<std::uint32_t>( ).swap( tags_ );
+            std::vector<key_type>( ).swap( keys_ );
+            size_ = 0;
+        }
+
+        /// The 20-byte hash of a standard P2PKH script
+        /// (OP_DUP OP_HASH160 <20> OP_EQUALVERIFY OP_CHECKSIG), found by
+        /// position only; nullptr for anything else.
+        static
+        const std::uint8_t *p2pkh_hash( const std::uint8_t *script,
+                                        std::size_t len )
+        {
+            enum { script_size = 3 + key_size + 2 };
+            if( len != script_size
+                || script[0] != 0x76 || script[1] != 0xa9 || script[2] != 0x14
+                || script[23] != 0x88 || script[24] != 0xac )
+            {
+                return nullptr;
+            }
+            return script + 3;
+        }
+
+        static
+        const std::uint8_t *p2pkh_hash( const output &o )
+        {
+            return o.script.empty( )
+                 ? nullptr
+                 : p2pkh_hash( o.script.data( ), o.script.size( ) );
+        }
+
+        /// true if 'o' pays a watched hash
+        bool match( const output &o ) const
+        {
+            auto h = p2pkh_hash( o );
+            return h && contains( h );
+        }
+
+        /// Outputs of 'txs' paying watched hashes, in transaction and
+        /// output order. Chunks of scan_grain transactions run on the
+        /// pool; inside a chunk, slots are prefetched probe_batch
+        /// outputs ahead of their lookups.
+        std::vector<hit> scan( const transaction *txs, std::size_t count,
+                               thread_pool *pool = nullptr ) const
+        {
+            std::vector<std::vector<hit> > parts(
+                                ( count + scan_grain - 1 ) / scan_grain );
+            thread_pool &tp = pool ? *pool : thread_pool::common( );
+
+            tp.parallel_for( count, scan_grain,
+                [this, txs, &parts]( std::size_t b, std::size_t e ) {
+                    for( ; b<e; b+=scan_grain ) {
+                        std::size_t last = ( e - b < scan_grain )
+                                         ? e : b + scan_grain;
+                        scan_chunk( txs, b, last, parts[b / scan_grain] );
+                    }
+                } );
+
+            std::vector<hit> res;
+            for( auto &p: parts ) {
+                res.insert( res.end( ), p.begin( ), p.end( ) );
+            }
+            return res;
+        }
+
+        std::vector<hit> scan( const std::vector<transaction> &txs,
+                               thread_pool *pool = nullptr ) const
+        {
+            return scan( txs.data( ), txs.size( ), pool );
+        }
+
+    private:
+
+        enum { min_capacity = 64 };
+
+        static
+        std::uint32_t load32( const std::uint8_t *p )
+        {
+            std::uint32_t res;
+            memcpy( &res, p, sizeof(res) );
+            return res;
+        }
+
+        static
+        std::size_t slot_of( const std::uint8_t *h160 )
+        {
+            return load32( h160 );
+        }
+
+        /// never zero; zero marks an empty slot
+        static
+        std::uint32_t tag_of( const std::uint8_t *h160 )
+        {
+            return load32( h160 + 4 ) | 1u;
+        }
+
+        bool place( const std::uint8_t *h160 )
+        {
+            const std::size_t mask = tags_.size( ) - 1;
+            const std::uint32_t tag = tag_of( h160 );
+            for( std::size_t i = slot_of( h160 ) & mask; ; i = ( i + 1 ) & mask ) {
+                if( tags_[i] == 0 ) {
+                    tags_[i] = tag;
+                    memcpy( keys_[i].data( ), h160, key_size );
+                    return true;
+                }
+                if( tags_[i] == tag &&
+                    memcmp( keys_[i].data( ), h160, key_size ) == 0 )
+                {
+                    return false;
+                }
+            }
+        }
+
+        void rehash( std::size_t cap )
+        {
+            std::vector<std::uint32_t> old_tags(cap, 0);
+            std::vector<key_type>      old_keys(cap);
+            old_tags.swap( tags_ );
+            old_keys.swap( keys_ );
+            for( std::size_t i=0; i<old_tags.size( ); ++i ) {
+                if( old_tags[i] ) {
+                    place( old_keys[i].data( ) );
+                }
+            }
+        }
+
+        static
+        void prefetch( const void *p )
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            __builtin_prefetch( p );
+#else
+            (void)p;
+#endif
+        }
+
+        void scan_chunk( const transaction *txs, std::size_t b,
+                         std::size_t e, std::vector<hit> &out ) const
+        {
+            if( size_ == 0 ) {
+                return;
+            }
+            const std::size_t mask = tags_.size( ) - 1;
+
+            struct pending {
+                const std::uint8_t *hash;
+                std::size_t         tx;
+                std::uint32_t       output;
+            };
+            pending     batch[probe_batch];
+            std::size_t n = 0;
+
+            auto flush = [&]( ) {
+                for( std::size_t i=0; i<n; ++i ) {
+                    if( contains( batch[i].hash ) ) {
+                        out.push_back( hit { batch[i].tx, batch[i].output } );
+                    }
+                }
+                n = 0;
+            };
+
+            for( std::size_t t=b; t<e; ++t ) {
+                auto &outs = txs[t].tx_out( );
+                for( std::size_t o=0; o<outs.size( ); ++o ) {
+                    auto h = p2pkh_hash( outs[o] );
+                    if( !h ) {
+                        continue;
+                    }
+                    prefetch( &tags_[slot_of( h ) & mask] );
+                    batch[n++] = pending { h, t, static_cast<std::uint32_t>(o) };
+                    if( n == probe_batch ) {
+                        flush( );
+                    }
+                }
+            }
+            flush( );
+        }
+
+        std::vector<std::uint32_t>  tags_;
+        std::vector<key_type>       keys_;
+        std::size_t                 size_ = 0;
+    };
+
+}}
+
+#endif // BLOCK_CHAIN_WATCH_LIST_H